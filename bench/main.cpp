@@ -0,0 +1,378 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements.hpp>
+#include <elements/support/context.hpp>
+#include <algorithm>
+#include <random>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Allocation counting. We interpose malloc and friends (glibc) so that the
+// allocations made by cairo are counted along with operator new.
+////////////////////////////////////////////////////////////////////////////////
+extern "C"
+{
+   void* __libc_malloc(std::size_t size);
+   void* __libc_calloc(std::size_t n, std::size_t size);
+   void* __libc_realloc(void* p, std::size_t size);
+}
+
+namespace
+{
+   std::atomic<std::size_t> num_allocations{ 0 };
+}
+
+extern "C"
+{
+   void* malloc(std::size_t size) noexcept
+   {
+      ++num_allocations;
+      return __libc_malloc(size);
+   }
+
+   void* calloc(std::size_t n, std::size_t size) noexcept
+   {
+      ++num_allocations;
+      return __libc_calloc(n, size);
+   }
+
+   void* realloc(void* p, std::size_t size) noexcept
+   {
+      ++num_allocations;
+      return __libc_realloc(p, size);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The example element trees. Each example is compiled into its own namespace
+// with its main function renamed. This way, we benchmark exactly the same
+// element trees that the examples show, without opening any window.
+////////////////////////////////////////////////////////////////////////////////
+#define main example_main
+
+namespace layout_example
+{
+#include "../examples/layout/main.cpp"
+}
+
+namespace buttons_example
+{
+#include "../examples/buttons/main.cpp"
+}
+
+namespace sliders_example
+{
+#include "../examples/basic_sliders_and_knobs/main.cpp"
+}
+
+namespace text_edit_example
+{
+#include "../examples/text_edit/main.cpp"
+}
+
+#undef main
+
+using namespace cycfi::elements;
+
+namespace
+{
+   constexpr extent  view_size = { 1024, 768 };
+   constexpr rect    view_bounds = { 0, 0, view_size.x, view_size.y };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Timing
+   ////////////////////////////////////////////////////////////////////////////
+   using clock_type = std::chrono::steady_clock;
+
+   template <typename F>
+   double time_it(int iterations, F f)
+   {
+      auto start = clock_type::now();
+      for (int i = 0; i != iterations; ++i)
+         f();
+      std::chrono::duration<double, std::micro> elapsed = clock_type::now() - start;
+      return elapsed.count() / iterations;
+   }
+
+   void report(char const* scene, char const* what, double usec)
+   {
+      std::printf("%-28s %-14s %12.2f us\n", scene, what, usec);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Benchmark a single scene. The view is offscreen, we draw into our own
+   // image surface so that we time only the elements and not the host.
+   ////////////////////////////////////////////////////////////////////////////
+   void bench(char const* scene, view& view_, int iterations)
+   {
+      auto surface_ = cairo_image_surface_create(
+         CAIRO_FORMAT_ARGB32, view_size.x, view_size.y);
+      auto cr = cairo_create(surface_);
+      canvas cnv{ *cr };
+      auto& content = view_.content();
+
+      // Flush the tasks posted while building the content
+      view_.poll();
+
+      // Initial limits and layout
+      view_.draw(cr, view_bounds);
+
+      // Limits
+      basic_context bctx{ view_, cnv };
+      report(scene, "limits", time_it(iterations,
+         [&]{ content.limits(bctx); }
+      ));
+
+      // Layout (everything is invalidated on each iteration)
+      context ctx{ view_, cnv, &content, view_bounds };
+      report(scene, "layout", time_it(iterations,
+         [&]
+         {
+            content.invalidate(nullptr, element::layout_dirty);
+            content.layout(ctx);
+         }
+      ));
+
+      // Full draw
+      report(scene, "full draw", time_it(iterations,
+         [&]{ view_.draw(cr, view_bounds); }
+      ));
+
+      // Partial draw: a small area at the center of the view
+      rect area = { 480, 352, 544, 416 };
+      report(scene, "partial draw", time_it(iterations,
+         [&]
+         {
+            cairo_save(cr);
+            cairo_rectangle(cr, area.left, area.top, area.width(), area.height());
+            cairo_clip(cr);
+            view_.draw(cr, area);
+            cairo_restore(cr);
+         }
+      ));
+
+      // Hit test over a 16x16 grid of points
+      report(scene, "hit-test", time_it(iterations,
+         [&]
+         {
+            for (int y = 0; y != 16; ++y)
+               for (int x = 0; x != 16; ++x)
+                  content.hit_test(ctx, { (x + 0.5f) * view_size.x / 16, (y + 0.5f) * view_size.y / 16 });
+         }
+      ));
+
+      // Motion events: time and number of allocations per event on the
+      // dispatch path
+      {
+         auto motion = [&view_](int i)
+         {
+            point p = { float((i * 37) % int(view_size.x)), float((i * 23) % int(view_size.y)) };
+            view_.cursor(p, cursor_tracking::hovering);
+         };
+
+         int n = iterations * 16;
+         motion(0); // warm up
+         auto allocs = num_allocations.load();
+         int i = 0;
+         report(scene, "motion", time_it(n, [&]{ motion(++i); }));
+         std::printf("%-28s %-14s %12.2f allocs/event\n", scene, "motion",
+            double(num_allocations.load() - allocs) / n);
+      }
+
+      // Drain whatever was posted while benchmarking
+      view_.poll();
+
+      cairo_destroy(cr);
+      cairo_surface_destroy(surface_);
+   }
+
+   void bench_layout(int iterations)
+   {
+      using namespace layout_example;
+
+      auto pages = std::vector<std::pair<char const*, element_ptr>>
+      {
+         { "layout/aligns", share(make_aligns()) },
+         { "layout/percentages", share(make_percentages()) },
+         { "layout/mixed", share(make_mixed()) },
+         { "layout/flow", share(make_flow()) }
+      };
+
+      for (auto const& page : pages)
+      {
+         view view_(view_size);
+         view_.content(
+            {
+               share(margin({ 10, 10, 10, 10 }, hold(page.second))),
+               share(background)
+            }
+         );
+         bench(page.first, view_, iterations);
+      }
+   }
+
+   void bench_buttons(int iterations)
+   {
+      using namespace buttons_example;
+
+      view view_(view_size);
+      view_.content(
+         {
+            share(make_controls(view_)),
+            share(background)
+         }
+      );
+      bench("buttons", view_, iterations);
+   }
+
+   void bench_sliders(int iterations)
+   {
+      using namespace sliders_example;
+
+      view view_(view_size);
+      view_.content(
+         {
+            share(make_controls()),
+            share(background)
+         }
+      );
+      link_controls(view_);
+      bench("basic_sliders_and_knobs", view_, iterations);
+   }
+
+   void bench_text_edit(int iterations)
+   {
+      using namespace text_edit_example;
+
+      view view_(view_size);
+      view_.content(
+         {
+            make_edit_box(),
+            make_bkd()
+         }
+      );
+      bench("text_edit", view_, iterations);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Typing latency vs. document size. Characters are typed near the start
+   // of the document, so the text after the caret (most of it) moves.
+   ////////////////////////////////////////////////////////////////////////////
+   void bench_typing(int iterations)
+   {
+      std::string const paragraph =
+         "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do "
+         "eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim "
+         "ad minim veniam, quis nostrud exercitation ullamco laboris.\n";
+
+      auto surface_ = cairo_image_surface_create(
+         CAIRO_FORMAT_ARGB32, view_size.x, view_size.y);
+      auto cr = cairo_create(surface_);
+
+      for (std::size_t kbytes : { 1, 10, 100, 200 })
+      {
+         std::string doc;
+         while (doc.size() < kbytes * 1024)
+            doc += paragraph;
+
+         auto box = basic_text_box(doc);
+
+         view view_(view_size);
+         view_.content(
+            {
+               share(
+                  scroller(
+                     margin(
+                        { 20, 20, 20, 20 },
+                        align_left_top(hsize(800, std::move(box)))
+                     )
+                  )
+               )
+            }
+         );
+         view_.poll();
+         view_.draw(cr, view_bounds);
+
+         // Place the caret on the second line
+         point pos = { 100, 50 };
+         view_.click({ true, 1, mouse_button::left, 0, pos });
+         view_.click({ false, 1, mouse_button::left, 0, pos });
+
+         char scene[32];
+         std::snprintf(scene, sizeof(scene), "typing/%zuKB", kbytes);
+         int i = 0;
+         report(scene, "keystroke", time_it(iterations,
+            [&]
+            {
+               view_.text({ uint32_t('a' + (i++ % 26)), 0 });
+               view_.draw(cr, view_bounds);
+            }
+         ));
+         view_.poll();
+      }
+
+      cairo_destroy(cr);
+      cairo_surface_destroy(surface_);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Re-wrapping on resize: breaking the shaped text into lines of
+   // alternating widths.
+   ////////////////////////////////////////////////////////////////////////////
+   void bench_rewrap(int iterations)
+   {
+      std::string const paragraph =
+         "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do "
+         "eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim "
+         "ad minim veniam, quis nostrud exercitation ullamco laboris.\n";
+
+      auto const& theme = get_theme();
+      for (std::size_t kbytes : { 1, 10, 100, 200 })
+      {
+         std::string doc;
+         while (doc.size() < kbytes * 1024)
+            doc += paragraph;
+
+         master_glyphs glyphs_{
+            doc.data(), doc.data() + doc.size()
+          , theme.text_box_font, theme.text_box_font_size
+         };
+
+         char scene[32];
+         std::snprintf(scene, sizeof(scene), "rewrap/%zuKB", kbytes);
+         std::vector<glyphs> rows;
+         int i = 0;
+         report(scene, "break_lines", time_it(iterations,
+            [&]
+            {
+               rows.clear();
+               glyphs_.break_lines((i++ % 2)? 400 : 800, rows);
+            }
+         ));
+      }
+   }
+}
+
+int main(int argc, char const* argv[])
+{
+   int iterations = (argc > 1)? std::max(std::atoi(argv[1]), 1) : 100;
+   std::printf("elements_bench: %d iterations, %gx%g view\n\n",
+      iterations, view_size.x, view_size.y);
+
+   bench_layout(iterations);
+   bench_buttons(iterations);
+   bench_sliders(iterations);
+   bench_text_edit(iterations);
+   bench_typing(iterations);
+   bench_rewrap(iterations);
+   return 0;
+}
@@ -14,6 +14,11 @@
 #include <json/json_io.hpp>
 #include <gtk/gtk.h>
 #include <string>
+#include <algorithm>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <set>
 
 namespace cycfi { namespace elements
 {
@@ -22,8 +27,20 @@ namespace cycfi { namespace elements
       host_view();
       ~host_view();
 
+      // The backing store. Its size may be larger than the widget's.
       cairo_surface_t* surface = nullptr;
+      int surface_width = 0;
+      int surface_height = 0;
       GtkWidget* widget = nullptr;
+      int width = 0;
+      int height = 0;
+
+      // The parts of the backing store that need to be rendered again
+      cairo_region_t* damage = nullptr;
+
+      // Offscreen views render into an image surface with no widget
+      bool offscreen = false;
+      extent offscreen_size;
 
       // Mouse button click tracking
       std::uint32_t click_time = 0;
@@ -39,7 +56,31 @@ namespace cycfi { namespace elements
 
       int modifiers = 0; // the latest modifiers
 
-      GtkIMContext* im_context;
+      GtkIMContext* im_context = nullptr;
+
+      // Input is coalesced until the next frame. Consecutive events of
+      // the same kind are merged (see merge_input). A pending key repeat
+      // or text has a zero count if there is none.
+      enum class input_kind { none, hover, drag, scroll, keyboard };
+      input_kind pending_input = input_kind::none;
+      mouse_button pending_button;
+      point pending_pos;
+      point pending_scroll;
+      key_info pending_key{ key_code::unknown, key_action::unknown, 0, 0 };
+      text_info pending_text{ 0, 0, 0 };
+
+      // The key being filtered by the input method, if any. Text entered
+      // while filtering a key press is produced by that key.
+      key_code text_key = key_code::unknown;
+
+      // Pending wakeups (see base_view::wake). Wakeups may be requested
+      // from any thread. An immediate wakeup is lock-free: it sets
+      // wake_pending, which wake_source checks, and wakes up the main
+      // context.
+      std::atomic<bool> wake_pending{ false };
+      GSource* wake_source = nullptr;
+      std::mutex wake_mutex;
+      std::set<guint> wake_timers;
    };
 
    struct platform_access
@@ -51,15 +92,23 @@ namespace cycfi { namespace elements
    };
 
    host_view::host_view()
-    : im_context(gtk_im_context_simple_new())
+    : damage(cairo_region_create())
    {
    }
 
    host_view::~host_view()
    {
+      if (wake_source)
+      {
+         g_source_destroy(wake_source);
+         g_source_unref(wake_source);
+      }
+      for (auto id : wake_timers)
+         g_source_remove(id);
       if (surface)
          cairo_surface_destroy(surface);
       surface = nullptr;
+      cairo_region_destroy(damage);
    }
 
    namespace
@@ -69,38 +118,220 @@ namespace cycfi { namespace elements
          return *reinterpret_cast<base_view*>(user_data);
       }
 
+      // Dispatch the pending coalesced input, if any
+      void flush_input(base_view& view)
+      {
+         using input_kind = host_view::input_kind;
+         auto* host_view_h = platform_access::get_host_view(view);
+         auto kind = host_view_h->pending_input;
+         host_view_h->pending_input = input_kind::none;
+
+         switch (kind)
+         {
+            case input_kind::hover:
+               view.cursor(host_view_h->pending_pos, cursor_tracking::hovering);
+               break;
+            case input_kind::drag:
+               view.drag(host_view_h->pending_button);
+               break;
+            case input_kind::scroll:
+               view.scroll(host_view_h->pending_scroll, host_view_h->pending_pos);
+               break;
+            case input_kind::keyboard:
+               {
+                  auto text = host_view_h->pending_text;
+                  auto key = host_view_h->pending_key;
+                  host_view_h->pending_text.count = 0;
+                  host_view_h->pending_key.count = 0;
+                  if (text.count)
+                     view.text(text);
+                  if (key.count)
+                     view.key(key);
+               }
+               break;
+            default:
+               break;
+         }
+      }
+
+      // Returns true if an event of the given kind can be merged into the
+      // pending input. Otherwise, the pending input is dispatched first,
+      // the event becomes the pending input and false is returned. The
+      // caller then initializes it.
+      bool merge_input(base_view& view, host_view::input_kind kind, bool same = true)
+      {
+         auto* host_view_h = platform_access::get_host_view(view);
+         if (host_view_h->pending_input == kind && same)
+            return true;
+         flush_input(view);
+         host_view_h->pending_input = kind;
+         view.wake();
+         return false;
+      }
+
+      // A held key enters text and repeats the key, alternately. Both are
+      // folded until the next frame, where the text is dispatched before
+      // the key repeats. A different text or key starts a new batch. In
+      // particular, text from another key must not be dispatched ahead of
+      // the pending key repeats.
+      void merge_text(base_view& view, text_info info)
+      {
+         auto* host_view_h = platform_access::get_host_view(view);
+         auto& pending = host_view_h->pending_text;
+         bool same = pending.codepoint == info.codepoint
+            && pending.modifiers == info.modifiers;
+         bool other_key = host_view_h->pending_key.count
+            && host_view_h->pending_key.key != host_view_h->text_key;
+
+         if ((pending.count && !same) || other_key)
+            flush_input(view);
+         merge_input(view, host_view::input_kind::keyboard);
+         if (pending.count)
+            ++pending.count;
+         else
+            pending = info;
+      }
+
+      void merge_key_repeat(base_view& view, key_info k)
+      {
+         auto* host_view_h = platform_access::get_host_view(view);
+         auto& pending = host_view_h->pending_key;
+         bool same = pending.key == k.key && pending.modifiers == k.modifiers;
+
+         if (pending.count && !same)
+            flush_input(view);
+         merge_input(view, host_view::input_kind::keyboard);
+         if (pending.count)
+            ++pending.count;
+         else
+            pending = k;
+      }
+
+      // The smallest whole-pixel rectangle enclosing r
+      cairo_rectangle_int_t to_pixels(rect r)
+      {
+         int x = std::floor(r.left);
+         int y = std::floor(r.top);
+         return {
+            x, y,
+            int(std::ceil(r.right)) - x,
+            int(std::ceil(r.bottom)) - y
+         };
+      }
+
+      // The backing store grows with some slack so that live resizing
+      // does not reallocate it on every configure event.
+      constexpr float surface_slack = 1.25;
+
       gboolean on_configure(GtkWidget* widget, GdkEventConfigure* event, gpointer user_data)
       {
          auto& view = get(user_data);
          auto* host_view_h = platform_access::get_host_view(view);
+         int w = gtk_widget_get_allocated_width(widget);
+         int h = gtk_widget_get_allocated_height(widget);
 
-         if (host_view_h->surface)
-            cairo_surface_destroy(host_view_h->surface);
+         if (!host_view_h->surface
+            || w > host_view_h->surface_width
+            || h > host_view_h->surface_height)
+         {
+            if (host_view_h->surface)
+               cairo_surface_destroy(host_view_h->surface);
+
+            host_view_h->surface_width = std::max<int>(w * surface_slack, host_view_h->surface_width);
+            host_view_h->surface_height = std::max<int>(h * surface_slack, host_view_h->surface_height);
+            host_view_h->surface = gdk_window_create_similar_surface(
+               gtk_widget_get_window(widget), CAIRO_CONTENT_COLOR,
+               host_view_h->surface_width,
+               host_view_h->surface_height
+            );
+         }
 
-         host_view_h->surface = gdk_window_create_similar_surface(
-            gtk_widget_get_window(widget), CAIRO_CONTENT_COLOR,
-            gtk_widget_get_allocated_width(widget),
-            gtk_widget_get_allocated_height(widget)
-         );
+         // The view will be laid out again if the size changed. Everything
+         // needs to be rendered.
+         if (w != host_view_h->width || h != host_view_h->height)
+         {
+            host_view_h->width = w;
+            host_view_h->height = h;
+            cairo_rectangle_int_t all = { 0, 0, w, h };
+            cairo_region_union_rectangle(host_view_h->damage, &all);
+         }
          return true;
       }
 
-      gboolean on_draw(GtkWidget* widget, cairo_t* cr, gpointer user_data)
+      void render(base_view& view, host_view& h, cairo_region_t* region)
       {
-         auto& view = get(user_data);
-         auto* host_view_h = platform_access::get_host_view(view);
-         cairo_set_source_surface(cr, host_view_h->surface, 0, 0);
+         auto cr = cairo_create(h.surface);
+         int n = cairo_region_num_rectangles(region);
+         for (int i = 0; i != n; ++i)
+         {
+            cairo_rectangle_int_t r;
+            cairo_region_get_rectangle(region, i, &r);
+            cairo_rectangle(cr, r.x, r.y, r.width, r.height);
+         }
+         cairo_clip(cr);
+
+         // Clear first, as the old on_draw did by painting the blank
+         // backing surface under the view
+         cairo_save(cr);
+         cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
          cairo_paint(cr);
+         cairo_restore(cr);
 
-         // Note that cr (cairo_t) is already clipped to only draw the
-         // exposed areas of the widget.
-         double left, top, right, bottom;
-         cairo_clip_extents(cr, &left, &top, &right, &bottom);
+         cairo_rectangle_int_t ext;
+         cairo_region_get_extents(region, &ext);
          view.draw(
             cr,
-            rect{ float(left), float(top), float(right), float(bottom) }
+            rect{
+               float(ext.x), float(ext.y),
+               float(ext.x + ext.width), float(ext.y + ext.height)
+            }
          );
+         cairo_destroy(cr);
+      }
+
+      gboolean on_draw(GtkWidget* widget, cairo_t* cr, gpointer user_data)
+      {
+         auto& view = get(user_data);
+         auto* host_view_h = platform_access::get_host_view(view);
+         if (!host_view_h->surface)
+            return false;
 
+         // Note that cr (cairo_t) is already clipped to only draw the
+         // exposed areas of the widget. Render the damaged parts of
+         // those areas into the backing store.
+         auto exposed = cairo_region_create();
+         auto clip_rects = cairo_copy_clip_rectangle_list(cr);
+         if (clip_rects->status == CAIRO_STATUS_SUCCESS)
+         {
+            for (int i = 0; i != clip_rects->num_rectangles; ++i)
+            {
+               auto const& r = clip_rects->rectangles[i];
+               auto ri = to_pixels(rect{
+                  float(r.x), float(r.y), float(r.x + r.width), float(r.y + r.height)
+               });
+               cairo_region_union_rectangle(exposed, &ri);
+            }
+         }
+         else
+         {
+            double left, top, right, bottom;
+            cairo_clip_extents(cr, &left, &top, &right, &bottom);
+            auto ri = to_pixels(rect{ float(left), float(top), float(right), float(bottom) });
+            cairo_region_union_rectangle(exposed, &ri);
+         }
+         cairo_rectangle_list_destroy(clip_rects);
+
+         cairo_region_intersect(exposed, host_view_h->damage);
+         if (!cairo_region_is_empty(exposed))
+         {
+            cairo_region_subtract(host_view_h->damage, exposed);
+            render(view, *host_view_h, exposed);
+         }
+         cairo_region_destroy(exposed);
+
+         // Present the exposed areas from the backing store
+         cairo_set_source_surface(cr, host_view_h->surface, 0, 0);
+         cairo_paint(cr);
          return false;
       }
 
@@ -163,7 +394,10 @@ namespace cycfi { namespace elements
          auto& view = get(user_data);
          mouse_button btn;
          if (get_button(event, btn, platform_access::get_host_view(view)))
+         {
+            flush_input(view);
             view.click(btn);
+         }
          return true;
       }
 
@@ -196,10 +430,20 @@ namespace cycfi { namespace elements
                btn.down = false;
             }
 
+            // Only the latest position matters. A drag is merged with a
+            // pending drag of the same button and modifiers.
             if (btn.down)
-               base_view.drag(btn);
+            {
+               merge_input(base_view, host_view::input_kind::drag,
+                  view->pending_button.state == btn.state
+                  && view->pending_button.modifiers == btn.modifiers);
+               view->pending_button = btn;
+            }
             else
-               base_view.cursor(view->cursor_position, cursor_tracking::hovering);
+            {
+               merge_input(base_view, host_view::input_kind::hover);
+               view->pending_pos = view->cursor_position;
+            }
          }
          return true;
       }
@@ -238,10 +482,12 @@ namespace cycfi { namespace elements
                break;
          }
 
-         base_view.scroll(
-            { dx, dy },
-            { float(event->x), float(event->y) }
-         );
+         // Scroll deltas are summed until the next frame
+         if (!merge_input(base_view, host_view::input_kind::scroll))
+            host_view_h->pending_scroll = { 0, 0 };
+         host_view_h->pending_scroll.x += dx;
+         host_view_h->pending_scroll.y += dy;
+         host_view_h->pending_pos = { float(event->x), float(event->y) };
          return true;
       }
    }
@@ -251,6 +497,7 @@ namespace cycfi { namespace elements
       auto& base_view = get(user_data);
       auto* host_view_h = platform_access::get_host_view(base_view);
       host_view_h->cursor_position = point{ float(event->x), float(event->y) };
+      flush_input(base_view);
       base_view.cursor(
          host_view_h->cursor_position,
          (event->type == GDK_ENTER_NOTIFY) ?
@@ -268,7 +515,8 @@ namespace cycfi { namespace elements
       auto& base_view = get(user_data);
       auto* host_view_h = platform_access::get_host_view(base_view);
       auto cp = codepoint(str);
-      base_view.text({ cp, host_view_h->modifiers });
+
+      merge_text(base_view, { cp, host_view_h->modifiers });
    }
 
    int get_mods(int state)
@@ -292,6 +540,7 @@ namespace cycfi { namespace elements
 
       if (k.action == key_action::release)
       {
+         flush_input(_view);
          keys.erase(k.key);
          return;
       }
@@ -303,8 +552,13 @@ namespace cycfi { namespace elements
       keys[k.key] = k.action;
 
       if (repeated)
+      {
          k.action = key_action::repeat;
+         merge_key_repeat(_view, k);
+         return;
+      }
 
+      flush_input(_view);
       _view.key(k);
    };
 
@@ -312,9 +566,12 @@ namespace cycfi { namespace elements
    {
       auto& base_view = get(user_data);
       auto* host_view_h = platform_access::get_host_view(base_view);
+      auto const key = translate_key(event->keyval);
+
+      host_view_h->text_key = key;
       gtk_im_context_filter_keypress(host_view_h->im_context, event);
+      host_view_h->text_key = key_code::unknown;
 
-      auto const key = translate_key(event->keyval);
       if (key == key_code::unknown)
          return false;
 
@@ -329,15 +586,102 @@ namespace cycfi { namespace elements
    gboolean on_focus(GtkWidget* widget, GdkEventFocus* event, gpointer user_data)
    {
       auto& base_view = get(user_data);
+      flush_input(base_view);
       base_view.focus(event->in ?
          focus_request::begin_focus : focus_request::end_focus);
    }
 
-   int poll_function(gpointer user_data)
+   namespace
    {
+      void request_frame(base_view& view)
+      {
+         auto* widget = platform_access::get_host_view(view)->widget;
+         if (widget && gtk_widget_get_realized(widget))
+         {
+            auto* clock = gtk_widget_get_frame_clock(widget);
+            gdk_frame_clock_request_phase(clock, GDK_FRAME_CLOCK_PHASE_UPDATE);
+         }
+      }
+
+      struct wake_source
+      {
+         GSource     source;
+         base_view*  view;
+      };
+
+      gboolean wake_prepare(GSource* source, gint* timeout)
+      {
+         auto& view = *reinterpret_cast<wake_source*>(source)->view;
+         *timeout = -1;
+         return platform_access::get_host_view(view)->wake_pending.load();
+      }
+
+      gboolean wake_check(GSource* source)
+      {
+         auto& view = *reinterpret_cast<wake_source*>(source)->view;
+         return platform_access::get_host_view(view)->wake_pending.load();
+      }
+
+      gboolean wake_dispatch(GSource* source, GSourceFunc, gpointer)
+      {
+         auto& view = *reinterpret_cast<wake_source*>(source)->view;
+         platform_access::get_host_view(view)->wake_pending = false;
+         request_frame(view);
+         return G_SOURCE_CONTINUE;
+      }
+
+      GSourceFuncs wake_source_funcs =
+      {
+         wake_prepare, wake_check, wake_dispatch, nullptr
+      };
+
+      GSource* make_wake_source(base_view& view)
+      {
+         auto* source = g_source_new(&wake_source_funcs, sizeof(wake_source));
+         reinterpret_cast<wake_source*>(source)->view = &view;
+         g_source_attach(source, nullptr);
+         return source;
+      }
+
+      gboolean on_wake_timer(gpointer user_data)
+      {
+         auto& view = get(user_data);
+         auto* host_view_h = platform_access::get_host_view(view);
+         {
+            std::lock_guard<std::mutex> lock(host_view_h->wake_mutex);
+            host_view_h->wake_timers.erase(g_source_get_id(g_main_current_source()));
+         }
+         request_frame(view);
+         return G_SOURCE_REMOVE;
+      }
+   }
+
+   void on_frame_update(GdkFrameClock* clock, gpointer user_data)
+   {
+      // Runs once per frame, in the frame clock's update phase, before
+      // layout and paint. Anything refreshed here is painted in the
+      // same frame.
       auto& base_view = get(user_data);
+      flush_input(base_view);
       base_view.poll();
-      return true;
+   }
+
+   void on_realize(GtkWidget* widget, gpointer user_data)
+   {
+      // Frames are requested only when there is something to do (see
+      // base_view::wake). Request one now for anything posted before
+      // the widget was realized.
+      auto* clock = gtk_widget_get_frame_clock(widget);
+      g_signal_connect(clock, "update",
+         G_CALLBACK(on_frame_update), user_data);
+      gdk_frame_clock_request_phase(clock, GDK_FRAME_CLOCK_PHASE_UPDATE);
+   }
+
+   void on_unrealize(GtkWidget* widget, gpointer user_data)
+   {
+      auto* clock = gtk_widget_get_frame_clock(widget);
+      g_signal_handlers_disconnect_by_func(
+         clock, (gpointer) on_frame_update, user_data);
    }
 
    GtkWidget* make_view(base_view& view, GtkWidget* parent)
@@ -392,11 +736,19 @@ namespace cycfi { namespace elements
       );
 
       // Subscribe to text entry commit
+      view.host()->im_context = gtk_im_context_simple_new();
       g_signal_connect(view.host()->im_context, "commit",
          G_CALLBACK(on_text_entry), &view);
 
-      // Create 16ms (60Hz) timer
-      g_timeout_add(16, poll_function, &view);
+      // Drive posted work and refreshes from the frame clock, in sync
+      // with the display refresh. The clock runs only on demand.
+      view.host()->wake_source = make_wake_source(view);
+      g_signal_connect(content_view, "realize",
+         G_CALLBACK(on_realize), &view);
+      g_signal_connect(content_view, "unrealize",
+         G_CALLBACK(on_unrealize), &view);
+      if (gtk_widget_get_realized(content_view))
+         on_realize(content_view, &view);
 
       return content_view;
    }
@@ -420,11 +772,24 @@ namespace cycfi { namespace elements
       }
    };
 
+   namespace
+   {
+      cairo_surface_t* make_offscreen_surface(extent size_)
+      {
+         return cairo_image_surface_create(
+            CAIRO_FORMAT_ARGB32, std::max<int>(size_.x, 1), std::max<int>(size_.y, 1)
+         );
+      }
+   }
+
    base_view::base_view(extent size_)
     : base_view(new host_view)
    {
-      // $$$ FIXME: Implement Me $$$
-      CYCFI_ASSERT(false, "Unimplemented");
+      // Offscreen view: we render into an image surface. No GTK widget
+      // (and no display) is needed.
+      _view->offscreen = true;
+      _view->offscreen_size = size_;
+      _view->surface = make_offscreen_surface(size_);
    }
 
    base_view::base_view(host_view_handle h)
@@ -460,6 +825,9 @@ namespace cycfi { namespace elements
 
    elements::extent base_view::size() const
    {
+      if (_view->offscreen)
+         return _view->offscreen_size;
+
       auto x = gtk_widget_get_allocated_width(_view->widget);
       auto y = gtk_widget_get_allocated_height(_view->widget);
       return { float(x), float(y) };
@@ -467,12 +835,29 @@ namespace cycfi { namespace elements
 
    void base_view::size(elements::extent p)
    {
+      if (_view->offscreen)
+      {
+         if (_view->surface)
+            cairo_surface_destroy(_view->surface);
+         _view->offscreen_size = p;
+         _view->surface = make_offscreen_surface(p);
+         refresh();
+         return;
+      }
+
       // $$$ Wrong: don't size the window!!! $$$
       gtk_window_resize(GTK_WINDOW(_view->widget), p.x, p.y);
    }
 
    void base_view::refresh()
    {
+      if (_view->offscreen)
+      {
+         auto size_ = _view->offscreen_size;
+         refresh({ 0, 0, size_.x, size_.y });
+         return;
+      }
+
       auto x = gtk_widget_get_allocated_width(_view->widget);
       auto y = gtk_widget_get_allocated_height(_view->widget);
       refresh({ 0, 0, float(x), float(y) });
@@ -480,20 +865,134 @@ namespace cycfi { namespace elements
 
    void base_view::refresh(rect area)
    {
+      // Offscreen views have no expose events. We draw the area
+      // immediately into the offscreen surface.
+      if (_view->offscreen)
+      {
+         auto cr = cairo_create(_view->surface);
+         cairo_rectangle(cr, area.left, area.top, area.width(), area.height());
+         cairo_clip(cr);
+         draw(cr, area);
+         cairo_destroy(cr);
+         return;
+      }
+
+      // Mark the area for rendering into the backing store, then ask GTK
+      // to present it
+      auto r = to_pixels(area);
+      cairo_region_union_rectangle(_view->damage, &r);
+
       auto scale = 1; // get_scale(_view->widget);
       gtk_widget_queue_draw_area(_view->widget,
-         area.left * scale,
-         area.top * scale,
-         area.width() * scale,
-         area.height() * scale
+         r.x * scale,
+         r.y * scale,
+         r.width * scale,
+         r.height * scale
       );
    }
 
+   void base_view::wake(std::chrono::milliseconds delay)
+   {
+      // Offscreen views are polled explicitly
+      if (_view->offscreen)
+         return;
+
+      // The actual frame request is made from the main thread.
+      // An immediate wakeup neither locks nor allocates, so it is safe
+      // to call from a real-time thread. g_timeout_add is thread safe.
+      if (delay.count() <= 0)
+      {
+         if (!_view->wake_pending.exchange(true))
+            g_main_context_wakeup(nullptr);
+      }
+      else
+      {
+         std::lock_guard<std::mutex> lock(_view->wake_mutex);
+         _view->wake_timers.insert(
+            g_timeout_add_full(G_PRIORITY_DEFAULT, delay.count(), on_wake_timer, this, nullptr));
+      }
+   }
+
+   namespace
+   {
+      void move_surface_area(cairo_surface_t* surface, cairo_rectangle_int_t r, int dx, int dy)
+      {
+         // Copy the area through a temporary surface (cairo does not
+         // support copying a surface onto itself).
+         auto tmp = cairo_surface_create_similar_image(
+            surface, CAIRO_FORMAT_ARGB32, r.width, r.height);
+         auto tmp_cr = cairo_create(tmp);
+         cairo_set_source_surface(tmp_cr, surface, -r.x, -r.y);
+         cairo_set_operator(tmp_cr, CAIRO_OPERATOR_SOURCE);
+         cairo_paint(tmp_cr);
+         cairo_destroy(tmp_cr);
+
+         auto cr = cairo_create(surface);
+         cairo_rectangle(cr, r.x, r.y, r.width, r.height);
+         cairo_clip(cr);
+         cairo_set_source_surface(cr, tmp, r.x + dx, r.y + dy);
+         cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+         cairo_paint(cr);
+         cairo_destroy(cr);
+         cairo_surface_destroy(tmp);
+      }
+
+      void move_damage(cairo_region_t* damage, cairo_rectangle_int_t r, int dx, int dy)
+      {
+         // The damage inside the area moves with the pixels
+         auto inside = cairo_region_create_rectangle(&r);
+         cairo_region_intersect(inside, damage);
+         cairo_region_subtract_rectangle(damage, &r);
+         cairo_region_translate(inside, dx, dy);
+         cairo_region_intersect_rectangle(inside, &r);
+         cairo_region_union(damage, inside);
+         cairo_region_destroy(inside);
+      }
+   }
+
+   bool base_view::scroll_area(rect area, point offset)
+   {
+      auto r = to_pixels(area);
+      int dx = offset.x;
+      int dy = offset.y;
+
+      if (!_view->surface || (!_view->offscreen && !_view->widget))
+         return false;
+
+      move_surface_area(_view->surface, r, dx, dy);
+      if (_view->offscreen)
+         return true;
+
+      // Present the moved area from the backing store
+      move_damage(_view->damage, r, dx, dy);
+      gtk_widget_queue_draw_area(_view->widget, r.x, r.y, r.width, r.height);
+      return true;
+   }
+
    std::string clipboard()
    {
       GtkClipboard* clip = gtk_clipboard_get(GDK_SELECTION_CLIPBOARD);
       gchar* text = gtk_clipboard_wait_for_text(clip);
-      return std::string(text);
+      if (!text)
+         return {};
+      std::string result(text);
+      g_free(text);
+      return result;
+   }
+
+   namespace
+   {
+      void on_clipboard_text(GtkClipboard* clip, gchar const* text, gpointer user_data)
+      {
+         std::unique_ptr<clipboard_function> f{ static_cast<clipboard_function*>(user_data) };
+         (*f)(text? std::string(text) : std::string{});
+      }
+   }
+
+   void clipboard_async(clipboard_function f)
+   {
+      GtkClipboard* clip = gtk_clipboard_get(GDK_SELECTION_CLIPBOARD);
+      gtk_clipboard_request_text(clip, on_clipboard_text, new clipboard_function(std::move(f)));
    }
 
    void clipboard(std::string const& text)
@@ -6,7 +6,9 @@
 #include <elements/base_view.hpp>
 #include <elements/support/resource_paths.hpp>
 #import <Cocoa/Cocoa.h>
+#import <CoreVideo/CoreVideo.h>
 #include <dlfcn.h>
+#include <atomic>
 #include <memory>
 #include <map>
 #include <cairo-quartz.h>
@@ -157,7 +159,8 @@ namespace
 
 @interface ELEMENTS_VIEW_CLASS : NSView <NSTextInputClient>
 {
-   NSTimer*                         _task;
+   CVDisplayLinkRef                 _display_link;
+   std::atomic<bool>                _wake_pending;
    NSTrackingArea*                  _tracking_area;
    NSMutableAttributedString*       _marked_text;
    key_map                          _keys;
@@ -168,6 +171,23 @@ namespace
 
 @compatibility_alias ElementsView ELEMENTS_VIEW_CLASS;
 
+@interface ElementsView ()
+- (void) wake_now;
+- (void) wake_after : (int64_t) nanoseconds;
+- (void) on_vsync;
+@end
+
+namespace
+{
+   CVReturn on_display_link(
+      CVDisplayLinkRef, CVTimeStamp const*, CVTimeStamp const*
+    , CVOptionFlags, CVOptionFlags*, void* user_data)
+   {
+      [(__bridge ElementsView*) user_data on_vsync];
+      return kCVReturnSuccess;
+   }
+}
+
 @implementation ElementsView
 
 - (void) elements_init : (ph::base_view*) view_
@@ -176,13 +196,13 @@ namespace
 
    _view = view_;
    _start = true;
-   _task =
-      [NSTimer scheduledTimerWithTimeInterval : 0.016 // 60Hz
-           target : self
-         selector : @selector(on_tick:)
-         userInfo : nil
-          repeats : YES
-      ];
+
+   // The view is polled once per display refresh, only while there is
+   // something to do (see base_view::wake). Poll once for anything posted
+   // before.
+   CVDisplayLinkCreateWithActiveCGDisplays(&_display_link);
+   CVDisplayLinkSetOutputCallback(_display_link, on_display_link, (__bridge void*) self);
+   [self wake_now];
 
    _tracking_area = nil;
    [self updateTrackingAreas];
@@ -192,13 +212,51 @@ namespace
 
 - (void) dealloc
 {
-   _task = nil;
+   [self detach_timer];
    _view = nullptr;
 }
 
-- (void) on_tick : (id) sender
+// May be called from any thread
+- (void) wake_now
 {
+   if (!_wake_pending.exchange(true))
+      CVDisplayLinkStart(_display_link);
+}
+
+// May be called from any thread
+- (void) wake_after : (int64_t) nanoseconds
+{
+   __weak ElementsView* weak_self = self;
+   dispatch_after(
+      dispatch_time(DISPATCH_TIME_NOW, nanoseconds)
+    , dispatch_get_main_queue()
+    , ^{ [weak_self wake_now]; }
+   );
+}
+
+// Called by the display link's thread, once per display refresh
+- (void) on_vsync
+{
+   if (!_wake_pending.exchange(false))
+      return;
+   __weak ElementsView* weak_self = self;
+   dispatch_async(dispatch_get_main_queue(), ^{ [weak_self on_frame]; });
+}
+
+- (void) on_frame
+{
+   if (!_view || !_display_link)
+      return;
    _view->poll();
+
+   // Stop the display link while there is nothing to do. A wakeup that
+   // came in while stopping it starts it again.
+   if (!_wake_pending)
+   {
+      CVDisplayLinkStop(_display_link);
+      if (_wake_pending)
+         CVDisplayLinkStart(_display_link);
+   }
 }
 
 - (void) attach_notifications
@@ -235,7 +293,12 @@ namespace
 
 - (void) detach_timer
 {
-   [_task invalidate];
+   if (_display_link)
+   {
+      CVDisplayLinkStop(_display_link);
+      CVDisplayLinkRelease(_display_link);
+      _display_link = nullptr;
+   }
 }
 
 - (BOOL) canBecomeKeyView
@@ -592,6 +655,32 @@ namespace cycfi { namespace elements
       ];
    }
 
+   bool base_view::scroll_area(rect area, point offset)
+   {
+      auto ns_view = get_mac_view(host());
+
+      // scrollRect:by: copies from the view's own backing store. Layer
+      // backed views do not have one. Let the caller redraw the area.
+      if ([ns_view layer])
+         return false;
+
+      // The pending refreshes move with the contents
+      auto r = CGRectMake(area.left, area.top, area.width(), area.height());
+      auto d = NSMakeSize(offset.x, offset.y);
+      [ns_view translateRectsNeedingDisplayInRect : r by : d];
+      [ns_view scrollRect : r by : d];
+      return true;
+   }
+
+   void base_view::wake(std::chrono::milliseconds delay)
+   {
+      auto ns_view = get_mac_view(host());
+      if (delay.count() <= 0)
+         [ns_view wake_now];
+      else
+         [ns_view wake_after : std::chrono::nanoseconds(delay).count()];
+   }
+
    std::string clipboard()
    {
       NSPasteboard* pasteboard = [NSPasteboard generalPasteboard];
@@ -604,6 +693,13 @@ namespace cycfi { namespace elements
       return [object UTF8String];
    }
 
+   void clipboard_async(clipboard_function f)
+   {
+      // The general pasteboard is read synchronously. NSPasteboard has no
+      // asynchronous read for plain text.
+      f(clipboard());
+   }
+
    void clipboard(std::string const& text)
    {
       NSArray* types = [NSArray arrayWithObjects:NSPasteboardTypeString, nil];
@@ -32,7 +32,10 @@
 #include <cairo.h>
 #include <cairo-win32.h>
 #include <Windowsx.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 
 namespace cycfi { namespace elements
 {
@@ -62,7 +65,8 @@ namespace cycfi { namespace elements
 
    namespace
    {
-      constexpr unsigned IDT_TIMER1 = 100;
+      constexpr unsigned IDT_WAKE = 100;
+      constexpr UINT WM_ELEMENTS_WAKE = WM_APP + 1;
       HCURSOR current_cursor = nullptr;
 
       struct view_info
@@ -83,6 +87,13 @@ namespace cycfi { namespace elements
          time_point     scroll_start;
          double         velocity = 0;
          key_map        keys;
+
+         // Pending wakeups (see base_view::wake). An immediate wakeup may
+         // be requested from any thread. It posts a message, once, until
+         // the view is polled. The rest is handled in the window's thread.
+         std::atomic<bool> wake_pending{ false };
+         time_point     next_wake = time_point::max();
+         time_point     last_frame;
       };
 
       view_info* get_view_info(HWND hwnd)
@@ -161,6 +172,44 @@ namespace cycfi { namespace elements
          return 0;
       }
 
+      // The display's refresh interval. The view is polled at most once
+      // per refresh.
+      std::chrono::microseconds frame_interval()
+      {
+         DEVMODEW mode = {};
+         mode.dmSize = sizeof(mode);
+         auto hz = 60;
+         if (EnumDisplaySettingsW(nullptr, ENUM_CURRENT_SETTINGS, &mode)
+            && mode.dmDisplayFrequency > 1)
+            hz = mode.dmDisplayFrequency;
+         return std::chrono::microseconds(1000000 / hz);
+      }
+
+      void poll_view(view_info* info)
+      {
+         info->wake_pending = false;
+         info->last_frame = std::chrono::steady_clock::now();
+         info->vptr->poll();
+      }
+
+      void schedule_poll(HWND hwnd, view_info* info, std::chrono::milliseconds delay)
+      {
+         static auto const interval = frame_interval();
+         auto now = std::chrono::steady_clock::now();
+         auto at = std::max(now + delay, info->last_frame + interval);
+         if (at <= now)
+         {
+            poll_view(info);
+         }
+         else if (at < info->next_wake)
+         {
+            // SetTimer replaces the pending timer, if any
+            info->next_wake = at;
+            auto ms = std::chrono::ceil<std::chrono::milliseconds>(at - now);
+            SetTimer(hwnd, IDT_WAKE, UINT(ms.count()), nullptr);
+         }
+      }
+
       int get_mods()
       {
          int mods = 0;
@@ -437,9 +486,17 @@ namespace cycfi { namespace elements
                   SetCursor(current_cursor);
                break;
 
+            case WM_ELEMENTS_WAKE:
+               schedule_poll(hwnd, info, std::chrono::milliseconds(wparam));
+               break;
+
             case WM_TIMER:
-               if (wparam == IDT_TIMER1)
-                  info->vptr->poll();
+               if (wparam == IDT_WAKE)
+               {
+                  KillTimer(hwnd, IDT_WAKE);
+                  info->next_wake = view_info::time_point::max();
+                  poll_view(info);
+               }
                break;
 
             case WM_KEYDOWN:
@@ -515,8 +572,9 @@ namespace cycfi { namespace elements
          view_info* info = new view_info{ _this };
          SetWindowLongPtrW(_view, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(info));
 
-         // Create 16ms (60Hz) timer
-         SetTimer(_view, IDT_TIMER1, 16, (TIMERPROC) nullptr);
+         // The view is polled when there is something to do (see
+         // base_view::wake). Poll once for anything posted before.
+         PostMessageW(_view, WM_ELEMENTS_WAKE, 0, 0);
 
          return _view;
       }
@@ -545,7 +603,7 @@ namespace cycfi { namespace elements
       if (info->offscreen_hdc)
          DeleteDC(info->offscreen_hdc);
 
-      KillTimer(_view, IDT_TIMER1);
+      KillTimer(_view, IDT_WAKE);
       delete info;
       DeleteObject(_view);
    }
@@ -599,6 +657,60 @@ namespace cycfi { namespace elements
       InvalidateRect(_view, &r, false);
    }
 
+   bool base_view::scroll_area(rect area, point offset)
+   {
+      auto info = get_view_info(_view);
+      if (!info->offscreen_hdc)
+         return false;
+
+      // Only whole device pixels can be moved
+      auto scale = GetDpiForWindow(_view) / 96.0;
+      auto whole = [](double x) { return x == std::round(x); };
+      double dx = offset.x * scale;
+      double dy = offset.y * scale;
+      if (!whole(dx) || !whole(dy) || !whole(area.left * scale) || !whole(area.top * scale)
+         || !whole(area.right * scale) || !whole(area.bottom * scale))
+         return false;
+
+      RECT r;
+      r.left = area.left * scale;
+      r.right = area.right * scale;
+      r.top = area.top * scale;
+      r.bottom = area.bottom * scale;
+
+      // Move the pixels in the off-screen buffer, then on the screen
+      HANDLE hold = SelectObject(info->offscreen_hdc, info->offscreen_buff);
+      ScrollDC(info->offscreen_hdc, int(dx), int(dy), &r, &r, nullptr, nullptr);
+      SelectObject(info->offscreen_hdc, hold);
+
+      HRGN pending = CreateRectRgn(0, 0, 0, 0);
+      GetUpdateRgn(_view, pending, false);
+      ScrollWindowEx(_view, int(dx), int(dy), &r, &r, nullptr, nullptr, 0);
+
+      // The pending refreshes move with the contents
+      OffsetRgn(pending, int(dx), int(dy));
+      InvalidateRgn(_view, pending, false);
+      DeleteObject(pending);
+      return true;
+   }
+
+   void base_view::wake(std::chrono::milliseconds delay)
+   {
+      // PostMessage may be called from any thread. Immediate wakeups are
+      // folded until the view is polled. Delayed wakeups are scheduled in
+      // the window's thread (see schedule_poll).
+      auto info = get_view_info(_view);
+      if (delay.count() <= 0)
+      {
+         if (!info->wake_pending.exchange(true))
+            PostMessageW(_view, WM_ELEMENTS_WAKE, 0, 0);
+      }
+      else
+      {
+         PostMessageW(_view, WM_ELEMENTS_WAKE, WPARAM(delay.count()), 0);
+      }
+   }
+
    std::string clipboard()
    {
       if (!OpenClipboard(nullptr))
@@ -620,6 +732,13 @@ namespace cycfi { namespace elements
       return utf8_encode(source);
    }
 
+   void clipboard_async(clipboard_function f)
+   {
+      // The clipboard data is rendered by its owner on request, so the
+      // read is synchronous.
+      f(clipboard());
+   }
+
    void clipboard(std::string const& text)
    {
       auto len = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, NULL, 0);
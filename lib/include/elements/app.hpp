@@ -8,6 +8,7 @@
 
 #include <string>
 #include <infra/support.hpp>
+#include <elements/support/thread_pool.hpp>
 
 #if defined(__linux__)
 typedef struct _GtkApplication GtkApplication;
@@ -28,6 +29,10 @@ namespace cycfi { namespace elements
       void                 run();
       void                 stop();
 
+      // Worker threads for work that should not block the UI (see
+      // view::async)
+      elements::thread_pool& thread_pool() { return _thread_pool; }
+
    private:
 
 #if defined(__APPLE__)
@@ -39,6 +44,7 @@ namespace cycfi { namespace elements
 #endif
 
       std::string          _app_name;
+      elements::thread_pool _thread_pool{ elements::thread_pool::application };
    };
 }}
 
@@ -9,8 +9,10 @@
 #include <utility>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <cstdint>
 #include <functional>
+#include <chrono>
 #include <cairo.h>
 
 #include <infra/support.hpp>
@@ -75,6 +77,7 @@ namespace cycfi { namespace elements
    {
       uint32_t codepoint;
       int      modifiers;
+      int      count = 1;     // Number of times the codepoint was entered
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -276,6 +279,10 @@ namespace cycfi { namespace elements
       key_code          key;
       key_action        action;
       int               modifiers;
+      int               count = 1;  // Number of key repeats folded into this event
+
+      // Composites replay the folded repeats, one at a time, to elements
+      // that do not handle count (see element::handles_repeat_count).
    };
 
    std::string diplay(key_code k, int mod);
@@ -327,6 +334,15 @@ namespace cycfi { namespace elements
       virtual void      refresh();
       virtual void      refresh(rect area);
 
+      // Move the pixels in area by offset. The exposed parts of area are
+      // refreshed. Returns false if the host cannot do it, in which case
+      // the caller should refresh the whole area instead.
+      virtual bool      scroll_area(rect area, point offset);
+
+      // Ask the host to call poll() after delay, or as soon as possible
+      // if delay is zero. This may be called from any thread.
+      void              wake(std::chrono::milliseconds delay = {});
+
       point             cursor_pos() const;
       extent            size() const;
       void              size(extent size_);
@@ -342,6 +358,13 @@ namespace cycfi { namespace elements
    std::string clipboard();
    void clipboard(std::string const& text);
 
+   // Read the clipboard without blocking. f is called on the UI thread
+   // with the clipboard text once it is available. The text is empty if the
+   // clipboard has none. Hosts that read the clipboard synchronously call f
+   // before clipboard_async returns. See also view::paste_clipboard.
+   using clipboard_function = std::function<void(std::string text)>;
+   void clipboard_async(clipboard_function f);
+
    ////////////////////////////////////////////////////////////////////////////
    // The Cursor
    enum class cursor_type
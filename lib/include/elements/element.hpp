@@ -7,8 +7,10 @@
 #define ELEMENTS_MAY_4_2016
 
 #include <elements/element/align.hpp>
+#include <elements/element/animated.hpp>
 #include <elements/element/misc.hpp>
 #include <elements/element/button.hpp>
+#include <elements/element/cache.hpp>
 #include <elements/element/composite.hpp>
 #include <elements/element/dial.hpp>
 #include <elements/element/floating.hpp>
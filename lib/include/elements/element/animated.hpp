@@ -0,0 +1,65 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_ANIMATED_OCTOBER_16_2019)
+#define ELEMENTS_ANIMATED_OCTOBER_16_2019
+
+#include <elements/element/proxy.hpp>
+#include <elements/support/animation.hpp>
+
+namespace cycfi { namespace elements
+{
+   class view;
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Animated elements
+   //
+   // The animated element draws its subject with an opacity and an offset
+   // that can be tweened using animate_opacity and animate_offset. The
+   // offset moves the subject's bounds, hit testing included.
+   ////////////////////////////////////////////////////////////////////////////
+   class animated_base : public proxy_base
+   {
+   public:
+
+      virtual void            draw(context const& ctx);
+      virtual void            refresh(context const& ctx, element& element, int outward = 0);
+      virtual void            prepare_subject(context& ctx);
+
+      using element::refresh;
+
+      float                   opacity() const         { return _opacity; }
+      void                    opacity(float val)      { _opacity = val; }
+      point                   offset() const          { return _offset; }
+      void                    offset(point val)       { _offset = val; }
+
+   private:
+
+      float                   _opacity = 1;
+      point                   _offset;
+      point                   _drawn_offset;
+   };
+
+   template <typename Subject>
+   inline proxy<Subject, animated_base>
+   animated(Subject&& subject)
+   {
+      return { std::forward<Subject>(subject) };
+   }
+
+   animator::animation_id
+   animate_opacity(
+      view& view_, animated_base& e, float to, animator::duration d
+    , easing::function ease = easing::ease_in_out
+   );
+
+   animator::animation_id
+   animate_offset(
+      view& view_, animated_base& e, point to, animator::duration d
+    , easing::function ease = easing::ease_in_out
+   );
+}}
+
+#endif
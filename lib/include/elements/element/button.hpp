@@ -32,6 +32,7 @@ namespace cycfi { namespace elements
       virtual element*  click(context const& ctx, mouse_button btn);
       virtual bool      cursor(context const& ctx, point p, cursor_tracking status);
       virtual void      drag(context const& ctx, mouse_button btn);
+      virtual bool      forwards_drag() const { return false; }
       virtual bool      is_control() const;
 
       virtual void      value(int new_state);
@@ -67,6 +68,7 @@ namespace cycfi { namespace elements
       virtual element*  hit_test(context const& ctx, point p) override;
       virtual element*  click(context const& ctx, mouse_button btn) override;
       virtual void      drag(context const& ctx, mouse_button btn) override;
+      virtual bool      forwards_drag() const override { return false; }
       virtual bool      is_control() const override;
 
       virtual void      value(int new_state) override;
@@ -107,6 +109,7 @@ namespace cycfi { namespace elements
 
       virtual element*  click(context const& ctx, mouse_button btn);
       virtual void      drag(context const& ctx, mouse_button btn);
+      virtual bool      forwards_drag() const { return false; }
 
    private:
 
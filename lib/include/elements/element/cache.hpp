@@ -0,0 +1,35 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_CACHE_OCTOBER_16_2019)
+#define ELEMENTS_CACHE_OCTOBER_16_2019
+
+#include <elements/element/proxy.hpp>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Cached elements
+   //
+   // The cached element always draws its subject through the view's render
+   // cache, however cheap the subject is to draw (see render_cache). Slow
+   // elements in composites are cached automatically.
+   ////////////////////////////////////////////////////////////////////////////
+   class cache_base : public proxy_base
+   {
+   public:
+
+      virtual void            draw(context const& ctx);
+   };
+
+   template <typename Subject>
+   inline proxy<Subject, cache_base>
+   cached(Subject&& subject)
+   {
+      return { std::forward<Subject>(subject) };
+   }
+}}
+
+#endif
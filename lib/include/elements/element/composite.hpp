@@ -44,6 +44,7 @@ namespace cycfi { namespace elements
       virtual void            layout(context const& ctx) = 0;
       virtual bool            scroll(context const& ctx, point dir, point p);
       virtual void            refresh(context const& ctx, element& element, int outward = 0);
+      virtual void            refresh(context const& ctx, element_list const& elements);
 
       using element::refresh;
 
@@ -60,8 +61,16 @@ namespace cycfi { namespace elements
       virtual element*        focus();
       virtual void            focus(std::size_t index);
       virtual bool            is_control() const;
+      virtual bool            handles_repeat_count() const;
+      virtual bool            forwards_drag() const;
       virtual void            reset();
 
+   // Invalidation
+
+      virtual bool            invalidate(element const* e, int what = all_dirty);
+
+      using element::invalidate;
+
    // Composite
 
       struct hit_info
@@ -71,13 +80,39 @@ namespace cycfi { namespace elements
          int                  index    = -1;
       };
 
+      struct index_range
+      {
+         std::size_t          first    = 0;
+         std::size_t          last     = 0;
+      };
+
       virtual hit_info        hit_element(context const& ctx, point p) const;
       virtual rect            bounds_of(context const& ctx, std::size_t index) const = 0;
+      virtual index_range     range_of(context const& ctx, rect area) const;
       virtual bool            reverse_index() const { return false; }
 
+   protected:
+
+      // Lays out the element at index and clears its limits and layout
+      // flags. Composites lay out their elements through this, so the
+      // flags tell later layouts which elements changed.
+      void                    layout_element(context const& ctx, std::size_t index, rect bounds);
+
    private:
 
+      using focus_chain_type = std::vector<int>;
+
       void                    new_focus(context const& ctx, int index);
+      focus_chain_type const& focus_chain();
+      int                     next_focus(int index, bool reverse);
+
+      // The indices of the elements that want the focus, in order. It is
+      // rebuilt after the composite is invalidated for layout or focus
+      // (focus_dirty) or resized, so focus(wants_focus) and tabbing do not
+      // have to scan the elements.
+      focus_chain_type        _focus_chain;
+      std::size_t             _focus_chain_size = 0;
+      bool                    _focus_chain_valid = false;
 
       int                     _focus = -1;
       int                     _saved_focus = -1;
@@ -12,11 +12,14 @@
 #include <memory>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 namespace cycfi { namespace elements
 {
    struct basic_context;
    class context;
+   class render_cache;
+   struct render_cache_entry;
 
    ////////////////////////////////////////////////////////////////////////////
    // Elements
@@ -31,14 +34,15 @@ namespace cycfi { namespace elements
 
       using element_ptr = std::shared_ptr<element>;
       using element_const_ptr = std::shared_ptr<element const>;
+      using element_list = std::vector<element*>;
 
                               element() {}
-                              virtual ~element() {}
+                              virtual ~element();
 
-                              element(element&&) = default;
-                              element(element const&) = default;
-      element&                operator=(element&&) = default;
-      element&                operator=(element const&) = default;
+                              element(element&& rhs);
+                              element(element const& rhs);
+      element&                operator=(element&& rhs);
+      element&                operator=(element const& rhs);
 
    // Image
 
@@ -51,6 +55,9 @@ namespace cycfi { namespace elements
       virtual void            refresh(context const& ctx, element& element, int outward = 0);
       void                    refresh(context const& ctx, int outward = 0) { refresh(ctx, *this, outward); }
 
+      // Refresh all the elements in a sorted list, in one pass
+      virtual void            refresh(context const& ctx, element_list const& elements);
+
    // Control
 
       virtual element*        click(context const& ctx, mouse_button btn);
@@ -64,6 +71,16 @@ namespace cycfi { namespace elements
       virtual element*        focus();
       virtual bool            is_control() const;
 
+      // True if key and text apply the key repeats folded into one event
+      // (key_info::count and text_info::count). Otherwise, the enclosing
+      // composite replays the repeats one at a time.
+      virtual bool            handles_repeat_count() const;
+
+      // True if drag only passes the drag on to the child being dragged,
+      // doing nothing of its own. A drag with the pointer captured starts
+      // at the first element of the captured path that does not forward.
+      virtual bool            forwards_drag() const;
+
    // Receiver
 
       virtual void            value(bool val);
@@ -73,9 +90,33 @@ namespace cycfi { namespace elements
 
       enum tracking { none, begin_tracking, while_tracking, end_tracking };
 
+   // Invalidation
+
+      enum dirty_flags
+      {
+         limits_dirty         = 1,
+         layout_dirty         = 2,
+         paint_dirty          = 4,
+         focus_dirty          = 8,     // focus(wants_focus) changed
+         all_dirty            = limits_dirty | layout_dirty | paint_dirty | focus_dirty
+      };
+
+      int                     dirty() const              { return _dirty; }
+      void                    mark_dirty(int what)       { _dirty |= what; }
+      void                    clear_dirty(int what)      { _dirty &= ~what; }
+      void                    invalidate(context const& ctx, int what = all_dirty);
+      virtual bool            invalidate(element const* e, int what = all_dirty);
+
    protected:
 
       void                    on_tracking(context const& ctx, tracking state);
+
+   private:
+
+      friend class render_cache;
+
+      int                     _dirty = all_dirty;
+      render_cache_entry*     _cache_entry = nullptr;   // see render_cache
    };
 
    ////////////////////////////////////////////////////////////////////////////
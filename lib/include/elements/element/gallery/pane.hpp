@@ -7,9 +7,11 @@
 #define ELEMENTS_GALLERY_PANE_JUNE_5_2016
 
 #include <elements/element/align.hpp>
+#include <elements/element/cache.hpp>
 #include <elements/element/layer.hpp>
 #include <elements/element/margin.hpp>
 #include <elements/element/misc.hpp>
+#include <elements/support/draw_utils.hpp>
 
 namespace cycfi { namespace elements
 {
@@ -27,16 +29,18 @@ namespace cycfi { namespace elements
       return
         layer(
             align_top(
-               layer(
-                  halign(
-                     align_,
-                     margin({10, 4, 10, 4}, std::forward<Heading>(heading))
-                  ),
-                  title_bar{}
+               cached(
+                  layer(
+                     halign(
+                        align_,
+                        margin({10, 4, 10, 4}, std::forward<Heading>(heading))
+                     ),
+                     title_bar{}
+                  )
                )
             ),
             top_margin(40, std::forward<Content>(content)),
-            panel{}
+            cached(panel{})
         );
    }
 
@@ -33,6 +33,7 @@ namespace cycfi { namespace elements
       virtual void            layout(context const& ctx);
       virtual bool            scroll(context const& ctx, point dir, point p);
       virtual void            refresh(context const& ctx, element& element, int outward = 0);
+      virtual void            refresh(context const& ctx, element::element_list const& elements);
 
       using element::refresh;
 
@@ -48,6 +49,8 @@ namespace cycfi { namespace elements
       virtual element const*  focus() const;
       virtual element*        focus();
       virtual bool            is_control() const;
+      virtual bool            handles_repeat_count() const;
+      virtual bool            forwards_drag() const;
 
    // Receiver
 
@@ -55,6 +58,12 @@ namespace cycfi { namespace elements
       virtual void            value(int val);
       virtual void            value(double val);
       virtual void            value(std::string val);
+
+   // Invalidation
+
+      virtual bool            invalidate(element const* e, int what = element::all_dirty);
+
+      using element::invalidate;
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -142,12 +151,16 @@ namespace cycfi { namespace elements
    indirect<Base>::draw(context const& ctx)
    {
       this->get().draw(ctx);
+      this->get().clear_dirty(element::paint_dirty);
    }
 
    template <typename Base>
    inline void
    indirect<Base>::layout(context const& ctx)
    {
+      // Whoever lays us out clears our flags. The flags of the element we
+      // refer to are ours to clear.
+      this->get().clear_dirty(element::limits_dirty | element::layout_dirty);
       this->get().layout(ctx);
    }
 
@@ -165,6 +178,13 @@ namespace cycfi { namespace elements
       this->get().refresh(ctx, element, outward);
    }
 
+   template <typename Base>
+   inline void
+   indirect<Base>::refresh(context const& ctx, element::element_list const& elements)
+   {
+      this->get().refresh(ctx, elements);
+   }
+
    template <typename Base>
    inline element*
    indirect<Base>::click(context const& ctx, mouse_button btn)
@@ -228,6 +248,20 @@ namespace cycfi { namespace elements
       return this->get().is_control();
    }
 
+   template <typename Base>
+   inline bool
+   indirect<Base>::handles_repeat_count() const
+   {
+      return this->get().handles_repeat_count();
+   }
+
+   template <typename Base>
+   inline bool
+   indirect<Base>::forwards_drag() const
+   {
+      return this->get().forwards_drag();
+   }
+
    template <typename Base>
    inline void indirect<Base>::value(bool val)
    {
@@ -252,6 +286,15 @@ namespace cycfi { namespace elements
       this->get().value(val);
    }
 
+   template <typename Base>
+   inline bool
+   indirect<Base>::invalidate(element const* e, int what)
+   {
+      if (this->get().invalidate(e, what))
+         return Base::invalidate(nullptr, what);
+      return Base::invalidate(e, what);
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // reference (inline) implementation
    ////////////////////////////////////////////////////////////////////////////
@@ -58,6 +58,7 @@ namespace cycfi { namespace elements
 
       virtual void         draw(context const& ctx);
       virtual void         refresh(context const& ctx, element& element, int outward = 0);
+      virtual void         refresh(context const& ctx, element_list const& elements);
       virtual hit_info     hit_element(context const& ctx, point p) const;
       virtual bool         focus(focus_request r);
 
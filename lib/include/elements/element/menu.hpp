@@ -37,10 +37,12 @@ namespace cycfi { namespace elements
                                  W1&& off, W2&& on
                                , menu_position pos = menu_position::bottom_right);
 
+      virtual void            layout(context const& ctx);
       virtual element*        click(context const& ctx, mouse_button btn);
       virtual void            drag(context const& ctx, mouse_button btn);
       virtual bool            key(context const& ctx, key_info k);
       virtual bool            focus(focus_request r);
+      virtual bool            handles_repeat_count() const  { return false; }
 
       menu_position           position() const              { return _position; }
       void                    position(menu_position pos)   { _position = pos; }
@@ -53,11 +55,31 @@ namespace cycfi { namespace elements
    private:
 
       void                    layout_menu(context const& ctx);
+      void                    add_accelerators(view& view_);
 
       using popup_ptr = std::shared_ptr<basic_popup_element>;
 
+      // The shortcuts of the menu items registered with a view. They are
+      // removed when the menu is destroyed, so a menu shared outside the
+      // view must not outlive it. A copy of the menu registers its own
+      // when it is laid out.
+      struct accelerators
+      {
+                              accelerators() = default;
+                              accelerators(accelerators const&) {}
+                              ~accelerators() { remove(); }
+
+         accelerators&        operator=(accelerators const&);
+
+         void                 remove();
+
+         view*                view_ = nullptr;
+         std::vector<view::accelerator_id> ids;
+      };
+
       popup_ptr               _popup;
       menu_position           _position;
+      accelerators            _accelerators;
    };
 
    template <typename W1, typename W2>
@@ -70,17 +92,12 @@ namespace cycfi { namespace elements
    inline void basic_menu::menu(Menu&& menu_)
    {
       _popup = std::dynamic_pointer_cast<basic_popup_element>(share(basic_popup(menu_)));
+      _accelerators.remove();
    }
 
    ////////////////////////////////////////////////////////////////////////////
    // Menu Items
    ////////////////////////////////////////////////////////////////////////////
-   struct shortcut_key
-   {
-      key_code    key = key_code::unknown;
-      int         modifiers = 0; // same as modifiers in key_info (see base_view.hpp)
-   };
-
    class basic_menu_item_element : public proxy_base, public selectable
    {
    public:
@@ -93,6 +110,7 @@ namespace cycfi { namespace elements
       virtual bool            key(context const& ctx, key_info k);
       virtual bool            cursor(context const& ctx, point p, cursor_tracking status);
       virtual bool            is_control() const;
+      virtual bool            handles_repeat_count() const  { return false; }
 
       menu_item_function      on_click;
       shortcut_key            shortcut;
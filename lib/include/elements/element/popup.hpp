@@ -25,15 +25,20 @@ namespace cycfi { namespace elements
                               {}
 
       virtual element*        hit_test(context const& ctx, point p);
+      virtual void            draw(context const& ctx);
+      virtual void            refresh(context const& ctx, element& element, int outward = 0);
       virtual element*        click(context const& ctx, mouse_button btn);
       virtual bool            cursor(context const& ctx, point p, cursor_tracking status);
 
+      using element::refresh;
+
       void                    open(view& view_, click_function on_click = {});
       void                    close(view& view_);
 
    private:
 
       click_function          _on_click;
+      float                   _opacity = 1;     // The popup fades in when opened
    };
 
    template <typename Subject>
@@ -38,6 +38,9 @@ namespace cycfi { namespace elements
 
       double                  _halign;
       double                  _valign;
+      view_limits             _subject_limits;
+      rect                    _subject_bounds;
+      bool                    _subject_valid = false;
    };
 
    template <typename Subject>
@@ -67,6 +70,9 @@ namespace cycfi { namespace elements
    private:
 
       double                  _valign;
+      view_limits             _subject_limits;
+      rect                    _subject_bounds;
+      bool                    _subject_valid = false;
    };
 
    template <typename Subject>
@@ -139,6 +145,8 @@ namespace cycfi { namespace elements
       virtual bool            cursor(context const& ctx, point p, cursor_tracking status);
       virtual bool            key(context const& ctx, key_info k);
       virtual bool            is_control() const;
+      virtual bool            handles_repeat_count() const { return false; }
+      virtual bool            forwards_drag() const { return false; }
 
       struct scrollbar_info
       {
@@ -170,12 +178,14 @@ namespace cycfi { namespace elements
 
       scrollbar_bounds  get_scrollbar_bounds(context const& ctx);
       bool              reposition(context const& ctx, point p);
+      void              scrolled(context const& ctx, double old_halign, double old_valign);
 
       bool              has_scrollbars() const { return !(_traits & no_scrollbars); }
       bool              allow_hscroll() const { return !(_traits & no_hscroll); }
       bool              allow_vscroll() const { return !(_traits & no_vscroll); }
 
       point             _offset;
+      point             _scroll_remainder;   // sub-pixel scroll not yet applied
       tracking_status   _tracking;
       int               _traits;
    };
@@ -29,6 +29,7 @@ namespace cycfi { namespace elements
       virtual void            draw(context const& ctx);
       virtual void            layout(context const& ctx);
       virtual void            refresh(context const& ctx, element& element, int outward = 0);
+      virtual void            refresh(context const& ctx, element_list const& elements);
       virtual bool            scroll(context const& ctx, point dir, point p);
       virtual void            prepare_subject(context& ctx);
       virtual void            prepare_subject(context& ctx, point& p);
@@ -48,6 +49,8 @@ namespace cycfi { namespace elements
       virtual element const*  focus() const;
       virtual element*        focus();
       virtual bool            is_control() const;
+      virtual bool            handles_repeat_count() const;
+      virtual bool            forwards_drag() const;
 
    // Proxy
 
@@ -60,6 +63,12 @@ namespace cycfi { namespace elements
       virtual void            value(int val);
       virtual void            value(double val);
       virtual void            value(std::string val);
+
+   // Invalidation
+
+      virtual bool            invalidate(element const* e, int what = all_dirty);
+
+      using element::invalidate;
    };
 
    template <typename Subject, typename Base = proxy_base>
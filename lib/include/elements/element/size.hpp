@@ -442,6 +442,7 @@ namespace cycfi { namespace elements
       virtual void            prepare_subject(context& ctx);
       virtual void            prepare_subject(context& ctx, point& p);
       virtual void            restore_subject(context& ctx);
+      virtual bool            forwards_drag() const { return false; }
 
    private:
 
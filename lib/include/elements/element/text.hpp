@@ -7,10 +7,13 @@
 #define ELEMENTS_TEXT_APRIL_17_2016
 
 #include <elements/support/glyphs.hpp>
+#include <elements/support/text_buffer.hpp>
 #include <elements/support/theme.hpp>
+#include <elements/support/timer_wheel.hpp>
 #include <elements/element/element.hpp>
 #include <boost/asio.hpp>
 
+#include <memory>
 #include <string_view>
 #include <string>
 #include <vector>
@@ -61,12 +64,18 @@ namespace cycfi { namespace elements
       void                    layout(context const& ctx) override;
       void                    draw(context const& ctx) override;
 
-      std::string_view        text() const override            { return _text; }
-      char const*             c_str() const override           { return _text.c_str(); }
+      std::string_view        text() const override            { return _buffer->view(); }
+      char const*             c_str() const override           { return _buffer->str().c_str(); }
       void                    text(std::string_view text) override;
 
       void                    value(std::string val) override;
 
+      // The text is kept in a text_buffer. Setting the buffer moves the
+      // text into it. The text is laid out from the buffer's str(), which
+      // must be contiguous.
+      text_buffer const&      buffer() const                   { return *_buffer; }
+      void                    buffer(text_buffer_ptr buffer_);
+
       using element::text;
 
    private:
@@ -75,9 +84,8 @@ namespace cycfi { namespace elements
 
    protected:
 
-      std::string             _text;
+      text_buffer_ptr         _buffer;
       mutable master_glyphs   _layout;
-      std::vector<glyphs>     _rows;
       color                   _color;
       point                   _current_size = { -1, -1 };
    };
@@ -94,15 +102,17 @@ namespace cycfi { namespace elements
                                , float size        = get_theme().text_box_font_size
                               );
                               ~basic_text_box();
-                              basic_text_box(basic_text_box&& rhs) = default;
+                              basic_text_box(basic_text_box&& rhs);
 
       void                    draw(context const& ctx) override;
+      void                    layout(context const& ctx) override;
       element*                click(context const& ctx, mouse_button btn) override;
       void                    drag(context const& ctx, mouse_button btn) override;
       bool                    cursor(context const& ctx, point p, cursor_tracking status) override;
       bool                    key(context const& ctx, key_info k) override;
       bool                    focus(focus_request r) override;
       bool                    is_control() const override;
+      bool                    handles_repeat_count() const override { return true; }
 
       bool                    text(context const& ctx, text_info info) override;
       void                    text(std::string_view text) override;
@@ -126,6 +136,17 @@ namespace cycfi { namespace elements
 
       void                    scroll_into_view(context const& ctx, bool save_x);
 
+      // Edits are journaled for undo as replacements of a single range of
+      // the text. Replacements between begin_edit and end_edit (and typing
+      // runs, until another edit begins) are merged into one undo step.
+      void                    begin_edit(view& v);
+      void                    end_edit(view& v);
+      void                    replace(int pos, int n, std::string_view text);
+      void                    pasted(view& v);
+
+      // Pending pastes are dropped when this expires
+      std::weak_ptr<char>     paste_token() const     { return _paste_token; }
+
    private:
 
       struct glyph_metrics
@@ -144,18 +165,23 @@ namespace cycfi { namespace elements
       virtual void            copy(view& v, int start, int end);
       virtual void            paste(view& v, int start, int end);
 
-      struct state_saver;
-      using state_saver_f = std::function<void()>;
+      struct text_edit;
+      using text_edit_ptr = std::shared_ptr<text_edit>;
 
-      state_saver_f           capture_state();
+      void                    commit_edit(view& v);
+      void                    stop_caret();
 
       int                     _select_start;
       int                     _select_end;
       float                   _current_x;
-      state_saver_f           _typing_state;
+      text_edit_ptr           _edit;
+      std::shared_ptr<char>   _paste_token;     // Expires with this box
+      view*                   _caret_view = nullptr;
+      timer_wheel::timer_id   _caret_timer;
       bool                    _is_focus : 1;
       bool                    _show_caret : 1;
       bool                    _caret_started : 1;
+      bool                    _scroll_pending : 1;
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -21,12 +21,13 @@ namespace cycfi { namespace elements
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            layout(context const& ctx);
       virtual rect            bounds_of(context const& ctx, std::size_t index) const;
+      virtual index_range     range_of(context const& ctx, rect area) const;
 
    private:
 
       std::vector<float>      _tiles;
-      float                   _left;
-      float                   _right;
+      float                   _left = 0;
+      float                   _right = 0;
    };
 
    using vtile_composite = vector_composite<vtile_element>;
@@ -51,12 +52,13 @@ namespace cycfi { namespace elements
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            layout(context const& ctx);
       virtual rect            bounds_of(context const& ctx, std::size_t index) const;
+      virtual index_range     range_of(context const& ctx, rect area) const;
 
    private:
 
       std::vector<float>      _tiles;
-      float                   _top;
-      float                   _bottom;
+      float                   _top = 0;
+      float                   _bottom = 0;
    };
 
    using htile_composite = vector_composite<htile_element>;
@@ -47,6 +47,7 @@ namespace cycfi { namespace elements
 
       virtual element*     click(context const& ctx, mouse_button btn);
       virtual void         drag(context const& ctx, mouse_button btn);
+      virtual bool         forwards_drag() const { return false; }
       virtual bool         is_control() const;
 
    protected:
@@ -0,0 +1,127 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_ACCELERATOR_OCTOBER_16_2019)
+#define ELEMENTS_ACCELERATOR_OCTOBER_16_2019
+
+#include <elements/base_view.hpp>
+#include <infra/support.hpp>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   class element;
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Shortcut keys
+   ////////////////////////////////////////////////////////////////////////////
+   struct shortcut_key
+   {
+      key_code    key = key_code::unknown;
+      int         modifiers = 0; // same as modifiers in key_info (see base_view.hpp)
+   };
+
+   inline bool operator==(shortcut_key a, shortcut_key b)
+   {
+      return a.key == b.key && a.modifiers == b.modifiers;
+   }
+
+   // The shortcut of a key press. mod_action is ignored, it always comes
+   // with the platform modifier it maps to.
+   inline shortcut_key shortcut_of(key_info const& k)
+   {
+      return { k.key, k.modifiers & ~mod_action };
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // accelerator_table: Maps shortcut keys to actions with a hash lookup.
+   //
+   // An accelerator may have a scope element. The client ranks each scope
+   // when looking up a key (see find): a negative rank means the scope is
+   // inactive, and the active accelerator with the highest rank wins. Among
+   // equal ranks, the most recently added wins.
+   //
+   // An action returns false if it no longer applies (e.g. its element was
+   // destroyed). It is then removed and the next candidate is tried.
+   ////////////////////////////////////////////////////////////////////////////
+   class accelerator_table : non_copyable
+   {
+   public:
+
+      using function = std::function<bool()>;
+      using accelerator_id = std::size_t;
+
+      accelerator_id       add(shortcut_key k, function f, element const* scope = nullptr);
+      bool                 remove(accelerator_id id);
+      std::size_t          size() const { return _ids.size(); }
+
+                           template <typename Rank>
+      bool                 call(shortcut_key k, Rank rank);
+
+   private:
+
+      struct entry
+      {
+         accelerator_id    id;
+         element const*    scope;
+         function          f;
+      };
+
+      struct key_hash
+      {
+         std::size_t operator()(shortcut_key k) const
+         {
+            return (std::size_t(k.key) << 8) ^ std::size_t(k.modifiers);
+         }
+      };
+
+      using entries = std::vector<entry>;
+
+      std::unordered_map<shortcut_key, entries, key_hash> _map;
+      std::unordered_map<accelerator_id, shortcut_key> _ids;
+      accelerator_id       _next_id = 1;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Inlines
+   ////////////////////////////////////////////////////////////////////////////
+   template <typename Rank>
+   inline bool accelerator_table::call(shortcut_key k, Rank rank)
+   {
+      auto i = _map.find(k);
+      while (i != _map.end() && !i->second.empty())
+      {
+         auto& list = i->second;
+         int best_rank = -1;
+         std::size_t best = list.size();
+         for (std::size_t j = 0; j != list.size(); ++j)
+         {
+            int r = (list[j].scope)? rank(list[j].scope) : 0;
+            if (r >= 0 && r >= best_rank)
+            {
+               best_rank = r;
+               best = j;
+            }
+         }
+         if (best == list.size())
+            return false;
+
+         // Copy the action, it may add or remove accelerators
+         auto id = list[best].id;
+         auto f = list[best].f;
+         if (f())
+            return true;
+
+         remove(id);
+         i = _map.find(k);
+      }
+      return false;
+   }
+}}
+
+#endif
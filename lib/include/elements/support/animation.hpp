@@ -0,0 +1,106 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_ANIMATION_OCTOBER_16_2019)
+#define ELEMENTS_ANIMATION_OCTOBER_16_2019
+
+#include <infra/support.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   class element;
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Easing functions map the normalized time t (0 to 1) to the normalized
+   // progress of an animation.
+   ////////////////////////////////////////////////////////////////////////////
+   namespace easing
+   {
+      using function = double(*)(double t);
+
+      double linear(double t);
+      double ease_in(double t);
+      double ease_out(double t);
+      double ease_in_out(double t);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // animator: Drives all the active animations of a view from one
+   // monotonic clock. Each tick updates every animation in one pass and
+   // reports the elements that changed. An animation starts at the first
+   // tick after it is added, so a late first frame does not skip it ahead.
+   //
+   // An animation of a given target and property replaces the running
+   // animation of the same target and property, if any.
+   //
+   // A target owned by a shared_ptr (see share) is held weakly. Its
+   // animations are dropped, without calling them, once it is destroyed.
+   // Any other target must outlive its animations.
+   ////////////////////////////////////////////////////////////////////////////
+   class animator : non_copyable
+   {
+   public:
+
+      using clock = std::chrono::steady_clock;
+      using time_point = clock::time_point;
+      using duration = clock::duration;
+      using update_function = std::function<void(double progress)>;
+      using done_function = std::function<void()>;
+      using animation_id = std::uint64_t;
+      using element_list = std::vector<element*>;
+
+      enum property
+      {
+         no_property = -1,    // never replaced
+         value_property,
+         opacity_property,
+         offset_property
+      };
+
+      animation_id         add(
+                              element* target
+                            , duration d
+                            , update_function update
+                            , easing::function ease = easing::ease_in_out
+                            , int property = no_property
+                            , done_function done = {}
+                           );
+
+      bool                 cancel(animation_id id);
+      bool                 active() const { return !_animations.empty(); }
+      std::size_t          size() const { return _animations.size(); }
+
+      // Update all animations at time now. The targets of the animations
+      // that were updated are added to updated.
+      void                 tick(time_point now, element_list& updated);
+
+   private:
+
+      struct animation
+      {
+         animation_id      id;
+         element*          target;
+         std::weak_ptr<element> owner;
+         bool              has_owner;
+         int               property;
+         time_point        start;
+         bool              started;
+         duration          length;
+         easing::function  ease;
+         update_function   update;
+         done_function     done;
+      };
+
+      std::vector<animation> _animations;
+      animation_id         _next_id = 1;
+   };
+}}
+
+#endif
@@ -199,6 +199,7 @@ namespace cycfi { namespace elements
    private:
 
       friend class glyphs;
+      friend class master_glyphs;
       friend struct blur;
       friend struct fill_blur;
 
@@ -42,17 +42,17 @@ namespace cycfi { namespace elements
 
       context(context const& rhs, elements::rect bounds_)
        : basic_context(rhs.view, rhs.canvas), element(rhs.element)
-       , parent(rhs.parent), bounds(bounds_)
+       , parent(rhs.parent), bounds(bounds_), visible(rhs.visible)
       {}
 
       context(context const& parent_, element* element_, elements::rect bounds_)
        : basic_context(parent_.view, parent_.canvas), element(element_)
-       , parent(&parent_), bounds(bounds_)
+       , parent(&parent_), bounds(bounds_), visible(parent_.visible)
       {}
 
       context(class view& view_, class canvas& canvas_, element* element_, elements::rect bounds_)
        : basic_context(view_, canvas_), element(element_)
-       , parent(0), bounds(bounds_)
+       , parent(0), bounds(bounds_), visible(bounds_)
       {}
 
       context(context const&) = default;
@@ -83,6 +83,10 @@ namespace cycfi { namespace elements
       context const*                parent;
       elements::rect                bounds;
 
+      // The effective visible rect: the view's dirty rect clipped by all
+      // the enclosing ports. Elements outside it need not be drawn.
+      elements::rect                visible;
+
    private:
 
       mutable feedback_function     _feedback;
@@ -9,6 +9,7 @@
 #include <infra/assert.hpp>
 #include <elements/support/canvas.hpp>
 #include <elements/support/text_utils.hpp>
+#include <cstdint>
 #include <vector>
 #include <stdexcept>
 #include <cairo.h>
@@ -25,15 +26,35 @@ namespace cycfi { namespace elements
    public:
                            glyphs(
                               char const* first, char const* last
-                            , int glyph_start, int glyph_end
-                            , int cluster_start, int cluster_end
+                            , cairo_glyph_t const* glyphs_, int glyph_count
+                            , cairo_text_cluster_t const* clusters_, int cluster_count
+                            , float const* advances
+                            , float const* cluster_x, int const* cluster_bytes
                             , master_glyphs const& master
                             , bool strip_leading_spaces
+                            , float y = 0
                            );
 
-      void                 draw(point pos, canvas& canvas_);
+      void                 draw(point pos, canvas& canvas_) const;
       float                width() const;
 
+                           // Rows made by master_glyphs::break_lines are
+                           // indexed: y is the row's offset from the top of
+                           // the text, and the clusters are found by binary
+                           // search. hit returns the cluster at x (end() if
+                           // past the last). position returns the first
+                           // cluster at or after utf8.
+      struct glyph_position
+      {
+         char const*       str;
+         float             left;
+         float             right;
+      };
+
+      float                y() const         { return _y; }
+      char const*          hit(float x) const;
+      glyph_position       position(char const* utf8) const;
+
                            // for_each F signature:
                            // bool f(char const* utf8, float left, float right);
                            template <typename F>
@@ -55,6 +76,8 @@ namespace cycfi { namespace elements
    protected:
                            glyphs(char const* first, char const* last);
 
+      friend class master_glyphs;
+
       using scaled_font = cairo_scaled_font_t;
       using glyph = cairo_glyph_t;
       using cluster = cairo_text_cluster_t;
@@ -63,11 +86,23 @@ namespace cycfi { namespace elements
       char const*          _first;
       char const*          _last;
       scaled_font*         _scaled_font   = nullptr;
-      glyph*               _glyphs        = nullptr;
+      glyph const*         _glyphs        = nullptr;
       int                  _glyph_count   = 0;
-      cluster*             _clusters      = nullptr;
+      cluster const*       _clusters      = nullptr;
       int                  _cluster_count = 0;
       cluster_flags        _clusterflags;
+
+      // Computed by master_glyphs when the text is shaped: the advance of
+      // each glyph
+      float const*         _advances      = nullptr;
+
+      // The row index, kept by master_glyphs per paragraph: the x of each
+      // cluster's left edge and its byte offset, both relative to the
+      // start of the paragraph. The row's entries start at its first
+      // cluster and end with an entry for the end of the row.
+      float                _y = 0;
+      float const*         _cluster_x     = nullptr;
+      int const*           _cluster_bytes = nullptr;
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -77,6 +112,23 @@ namespace cycfi { namespace elements
        : std::runtime_error("Error. Failed to build master glyphs.") {}
    };
 
+   ////////////////////////////////////////////////////////////////////////////
+   // master_glyphs: Owns the glyphs of the whole text. The text is shaped
+   // per paragraph (up to and including a newline). Each paragraph keeps
+   // its own glyphs, shaped from x = 0, with its clusters relative to its
+   // first byte. An edit replaces the data of the paragraphs it touches
+   // and leaves the others in place. Where the paragraphs after it start
+   // (in the text and on the single line of text) is brought up to date
+   // when next needed.
+   //
+   // Edits recorded with edit are applied by the next call to text, which
+   // then shapes only the paragraphs the edits touched. Without recorded
+   // edits, text shapes the whole text.
+   //
+   // break_lines(width) keeps the lines of the paragraphs that did not
+   // change since the last call (with the same width) and only breaks the
+   // others. The lines are available through lines().
+   ////////////////////////////////////////////////////////////////////////////
    class master_glyphs : public glyphs
    {
    public:
@@ -95,26 +147,111 @@ namespace cycfi { namespace elements
 
                            ~master_glyphs();
 
-      void                 break_lines(float width, std::vector<glyphs>& lines);
+      void                 draw(point pos, canvas& canvas_) const;
+      float                width() const;
+
+                           template <typename F>
+      void                 for_each(F f);
+
+      using line_list = std::vector<glyphs>;
+
+      void                 break_lines(float width, line_list& lines);
+      void                 break_lines(float width);
+      line_list const&     lines() const     { return _lines; }
+
       void                 text(char const* first, char const* last);
+      void                 edit(std::size_t pos, std::size_t n, std::size_t size);
+      bool                 edited() const    { return _edited; }
 
    private:
                            master_glyphs(master_glyphs const&) = delete;
       master_glyphs&       operator=(master_glyphs const& rhs) = delete;
 
-      void                 build();
+      struct paragraph
+      {
+         std::vector<glyph>   glyphs;
+         std::vector<cluster> clusters;
+         std::vector<float>   advances;
+         std::vector<float>   cluster_x;        // the row index (see glyphs),
+         std::vector<int>     cluster_bytes;    // with an entry for the end
+         std::size_t          bytes = 0;        // including the newline, if any
+         float                width = 0;
+         std::size_t          line_start = 0;   // its lines in _lines
+         std::size_t          line_count = 0;
+         bool                 broken = false;   // its lines are up to date
+
+         // Where it starts: the offset from _first, and the x on a single
+         // line. Only valid for the first _starts_valid paragraphs.
+         mutable std::size_t  start = 0;
+         mutable float        x = 0;
+      };
+
+      // Where a line is, relative to the start of its paragraph
+      struct line_span
+      {
+         std::size_t       first;
+         std::size_t       last;
+         int               glyph_start;
+         int               cluster_start;
+      };
+
+      using paragraphs = std::vector<paragraph>;
+      using line_spans = std::vector<line_span>;
+
+      void                 build(
+                              std::size_t first, std::size_t last
+                            , char const* from, char const* to
+                           );
+
+      float                shape(char const* first, char const* last, paragraph& para);
+      void                 update_starts(std::size_t n) const;
+      std::size_t          find_paragraph(std::size_t pos) const;
+
+      void                 break_paragraph(
+                              paragraph const& para, float width
+                            , float line_height, line_list& lines
+                            , line_spans* spans
+                           ) const;
+
+      void                 place(
+                              glyphs& line, paragraph const& para
+                            , line_span const& span, float y
+                           ) const;
+
+      paragraphs           _paragraphs;
+      mutable std::size_t  _starts_valid  = 0;
+
+      // The edits recorded since the last call to text: the bytes
+      // [_edit_first, _edit_last) of the new text replaced bytes of the
+      // old text, making it _edit_delta bytes longer.
+      bool                 _edited        = false;
+      std::size_t          _edit_first    = 0;
+      std::size_t          _edit_last     = 0;
+      std::ptrdiff_t       _edit_delta    = 0;
+
+      // The lines made by break_lines(width)
+      float                _lines_width   = -1;
+      line_list            _lines;
+      line_spans           _spans;
+
+      // Scratch space, kept to avoid reallocating on each edit. The data
+      // of the paragraphs replaced by an edit is reused by the next one.
+      paragraphs           _new_paragraphs;
+      line_list            _new_lines;
+      line_spans           _new_spans;
    };
 
    ////////////////////////////////////////////////////////////////////////////
    template <typename F>
    inline void glyphs::for_each(F f)
    {
+      if (_first == _last)
+         return;
+
       CYCFI_ASSERT(_scaled_font, "Precondition failure: _scaled_font must not be null");
       CYCFI_ASSERT(_glyphs, "Precondition failure: _glyphs must not be null");
       CYCFI_ASSERT(_clusters, "Precondition failure: _clusters must not be null");
-
-      if (_first == _last)
-         return;
+      CYCFI_ASSERT(_advances, "Precondition failure: _advances must not be null");
 
       int   glyph_index = 0;
       int   byte_index = 0;
@@ -124,11 +261,9 @@ namespace cycfi { namespace elements
       {
          cairo_text_cluster_t* cluster = _clusters + i;
          cairo_glyph_t* glyph = _glyphs + glyph_index;
-         cairo_text_extents_t extents;
-         cairo_scaled_font_glyph_extents(_scaled_font, glyph, 1, &extents);
 
          float x = glyph->x - start_x;
-         if (!f(_first + byte_index, x, x + extents.x_advance))
+         if (!f(_first + byte_index, x, x + _advances[glyph_index]))
             break;
 
          // glyph/byte position
@@ -136,6 +271,28 @@ namespace cycfi { namespace elements
          byte_index += cluster->num_bytes;
       }
    }
+
+   template <typename F>
+   inline void master_glyphs::for_each(F f)
+   {
+      update_starts(_paragraphs.size());
+      for (auto const& para : _paragraphs)
+      {
+         int         glyph_index = 0;
+         char const* utf8 = _first + para.start;
+
+         for (auto const& cluster : para.clusters)
+         {
+            float x = para.x + para.glyphs[glyph_index].x;
+            if (!f(utf8, x, x + para.advances[glyph_index]))
+               return;
+
+            // glyph/byte position
+            glyph_index += cluster.num_glyphs;
+            utf8 += cluster.num_bytes;
+         }
+      }
+   }
 }}
 
 #endif
@@ -0,0 +1,184 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_PARAMETER_CHANNEL_OCTOBER_16_2019)
+#define ELEMENTS_PARAMETER_CHANNEL_OCTOBER_16_2019
+
+#include <elements/base_view.hpp>
+#include <infra/support.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace cycfi { namespace elements
+{
+   class element;
+
+   ////////////////////////////////////////////////////////////////////////////
+   // parameter_channel pushes values into elements from another thread
+   // (e.g. a real-time audio thread). It keeps one slot per element with
+   // the latest value pushed to it: a newer value always replaces an older
+   // one that was not applied yet. push is wait-free and does not allocate.
+   // The view drains the channel once per frame, calling
+   // element::value(double) and refreshing the elements that changed. The
+   // changed slots are queued, so a drain costs only what changed.
+   //
+   // While values keep coming, the view polls the channel every frame. push
+   // wakes the view (a system call) only for the first value after the
+   // channel went idle.
+   //
+   // Each producer thread should have its own channel (see
+   // view::make_parameter_channel). The channel holds up to capacity
+   // distinct elements. The elements must outlive the channel or at least
+   // its registration with the view (see view::remove_parameter_channel).
+   ////////////////////////////////////////////////////////////////////////////
+   class parameter_channel : non_copyable
+   {
+   public:
+                           parameter_channel(base_view& view, std::size_t capacity);
+
+      // Producer side. Returns false (the value is dropped) if the channel
+      // already holds capacity other elements.
+      bool                 push(element& e, double val);
+
+      // Consumer side. Calls f(element&, double) once per element with
+      // its latest value. Returns true if the channel is active: the view
+      // should poll it again next frame.
+                           template <typename F>
+      bool                 drain(F&& f);
+
+   private:
+
+      struct slot
+      {
+         element*             e = nullptr;
+         std::atomic<double>  val{ 0 };
+         std::atomic<bool>    changed{ false };
+      };
+
+      std::size_t          find_slot(element& e);
+
+      base_view&           _view;
+      std::size_t          _capacity;
+      std::unique_ptr<slot[]> _slots;
+
+      // Producer side: the slot of each element (open addressing, indices
+      // are offset by one, zero is empty)
+      std::size_t          _index_mask;
+      std::unique_ptr<std::size_t[]> _index;
+      std::size_t          _size = 0;
+
+      // The changed slots, in the order they changed. A slot is queued at
+      // most once (until it is drained), so capacity entries are enough.
+      using slot_index = std::atomic<std::size_t>;
+      std::unique_ptr<slot_index[]> _changed;
+      alignas(64) std::atomic<std::size_t> _head{ 0 };      // producer
+      alignas(64) std::atomic<std::size_t> _tail{ 0 };      // consumer
+
+      // The view polls the channel (no wakeup needed), and the view was
+      // woken up since the last drain
+      alignas(64) std::atomic<bool> _watched{ false };
+      alignas(64) std::atomic<bool> _woken{ false };
+   };
+
+   using parameter_channel_ptr = std::shared_ptr<parameter_channel>;
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Inlines
+   ////////////////////////////////////////////////////////////////////////////
+   namespace detail
+   {
+      inline std::size_t ceil_pow2(std::size_t n)
+      {
+         std::size_t r = 1;
+         while (r < n)
+            r <<= 1;
+         return r;
+      }
+   }
+
+   inline parameter_channel::parameter_channel(base_view& view, std::size_t capacity)
+    : _view(view)
+    , _capacity(std::max<std::size_t>(capacity, 1))
+    , _slots(new slot[_capacity])
+    , _index_mask(detail::ceil_pow2(_capacity * 2) - 1)
+    , _index(new std::size_t[_index_mask + 1]())
+    , _changed(new slot_index[_capacity])
+   {
+   }
+
+   inline std::size_t parameter_channel::find_slot(element& e)
+   {
+      auto h = (reinterpret_cast<std::uintptr_t>(&e) >> 3) * 0x9E3779B1u;
+      for (auto i = h & _index_mask; ; i = (i + 1) & _index_mask)
+      {
+         auto ix = _index[i];
+         if (ix == 0)
+         {
+            // A new element: claim the next slot and publish it
+            if (_size == _capacity)
+               return 0;
+            _slots[_size].e = &e;
+            ix = _index[i] = ++_size;
+            return ix;
+         }
+         if (_slots[ix - 1].e == &e)
+            return ix;
+      }
+   }
+
+   inline bool parameter_channel::push(element& e, double val)
+   {
+      auto ix = find_slot(e);
+      if (ix == 0)
+         return false;
+
+      auto& s = _slots[ix - 1];
+      s.val.store(val, std::memory_order_relaxed);
+      if (!s.changed.exchange(true, std::memory_order_acq_rel))
+      {
+         auto head = _head.load(std::memory_order_relaxed);
+         _changed[head % _capacity].store(ix - 1, std::memory_order_relaxed);
+         _head.store(head + 1, std::memory_order_seq_cst);
+      }
+
+      if (!_watched.load(std::memory_order_seq_cst)
+         && !_woken.exchange(true, std::memory_order_relaxed))
+         _view.wake();
+      return true;
+   }
+
+   template <typename F>
+   inline bool parameter_channel::drain(F&& f)
+   {
+      _woken.store(false, std::memory_order_relaxed);
+
+      auto head = _head.load(std::memory_order_acquire);
+      auto tail = _tail.load(std::memory_order_relaxed);
+      if (head == tail)
+      {
+         // Idle. The next push wakes the view, unless it came in before
+         // we stopped watching.
+         _watched.store(false, std::memory_order_seq_cst);
+         return _head.load(std::memory_order_seq_cst) != tail;
+      }
+
+      for (; tail != head; ++tail)
+      {
+         // The slot is cleared after it is dequeued, so that a new value
+         // queues it again
+         auto& s = _slots[_changed[tail % _capacity].load(std::memory_order_relaxed)];
+         _tail.store(tail + 1, std::memory_order_release);
+         s.changed.exchange(false, std::memory_order_acquire);
+         f(*s.e, s.val.load(std::memory_order_relaxed));
+      }
+      _watched.store(true, std::memory_order_seq_cst);
+      return true;
+   }
+}}
+
+#endif
@@ -0,0 +1,118 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_RENDER_CACHE_OCTOBER_16_2019)
+#define ELEMENTS_RENDER_CACHE_OCTOBER_16_2019
+
+#include <elements/support/pixmap.hpp>
+#include <elements/support/rect.hpp>
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <memory>
+
+namespace cycfi { namespace elements
+{
+   class context;
+   class element;
+   class render_cache;
+
+   ////////////////////////////////////////////////////////////////////////////
+   // The pixmap of a cached element. The entries are owned by the view's
+   // render_cache. The element points to its entry and drops it when it is
+   // destroyed.
+   ////////////////////////////////////////////////////////////////////////////
+   struct render_cache_entry
+   {
+      using list = std::list<render_cache_entry>;
+
+      render_cache*           cache       = nullptr;
+      element*                owner       = nullptr;
+      list::iterator          pos;
+      std::unique_ptr<pixmap> image;
+      rect                    area;       // relative to the element's top-left
+      extent                  size;       // the element's size
+      float                   scale       = 1;
+      int                     stable      = 0;
+      int                     wait        = 0;
+      bool                    uncacheable = false;
+      std::size_t             bytes       = 0;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // render_cache: Retained bitmaps of static subtrees, one per view.
+   //
+   // An element drawn through the cache is rendered into an offscreen pixmap
+   // at device scale, once it was drawn stable_frames times without its
+   // paint being invalidated. Each time its pixmap is invalidated, the
+   // element has to stay stable twice as long (up to max_stable_frames)
+   // before it is rendered again. The pixmap is then blitted until the element's
+   // paint is invalidated (refresh(element), refresh(ctx) and invalidate
+   // mark it paint_dirty), an explicit refresh(rect) covers it, or its size
+   // or the device scale changes. A plain refresh() repaints the pixmaps as
+   // they are. Call flush() after changes the elements are not told about
+   // (e.g. a new theme).
+   //
+   // The pixmap covers everything the element draws, including what it
+   // draws outside its bounds (e.g. a panel's shadow), up to max_overdraw.
+   //
+   // Composites draw their elements through the cache (automatic). Elements
+   // that are not controls and took at least automatic_threshold() to draw
+   // are cached. cached(subject) (see cache.hpp) caches its subject whatever
+   // it costs to draw (always).
+   //
+   // The pixmaps share the cache's byte budget. The least recently drawn
+   // pixmaps are dropped first.
+   ////////////////////////////////////////////////////////////////////////////
+   class render_cache
+   {
+   public:
+
+      using duration = std::chrono::steady_clock::duration;
+
+      static constexpr int    stable_frames = 2;
+      static constexpr int    max_stable_frames = 64;
+      static constexpr float  max_overdraw = 32;
+
+                              render_cache() = default;
+                              render_cache(render_cache const&) = delete;
+                              ~render_cache();
+
+      render_cache&           operator=(render_cache const&) = delete;
+
+      enum mode { automatic, always };
+
+      void                    draw(context const& ctx, element& e, mode m = automatic);
+      void                    flush();
+      static void             flush(element& e);
+      static bool             is_cached(element const& e);
+
+      std::size_t             budget() const                   { return _budget; }
+      void                    budget(std::size_t bytes);
+      std::size_t             size() const                     { return _size; }
+
+      duration                automatic_threshold() const      { return _threshold; }
+      void                    automatic_threshold(duration d)  { _threshold = d; }
+
+   private:
+
+      using entry = render_cache_entry;
+      using entry_list = entry::list;
+
+      entry&                  add(element& e);
+      void                    remove(entry& en);
+      void                    release(entry& en);
+      bool                    render(context const& ctx, element& e, entry& en);
+      void                    trim();
+
+      entry_list              _entries;   // the most recently drawn first
+      std::size_t             _budget = 64 * 1024 * 1024;
+      std::size_t             _size = 0;
+      duration                _threshold = std::chrono::microseconds(250);
+      bool                    _rendering = false;
+   };
+}}
+
+#endif
@@ -0,0 +1,77 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_TEXT_BUFFER_OCTOBER_16_2019)
+#define ELEMENTS_TEXT_BUFFER_OCTOBER_16_2019
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // text_buffer: The storage of editable text. Positions are byte offsets
+   // into the UTF-8 text.
+   //
+   // str() returns a contiguous, null terminated snapshot of the text. The
+   // snapshot (and pointers into it) stay valid until the next edit.
+   ////////////////////////////////////////////////////////////////////////////
+   class text_buffer
+   {
+   public:
+
+      virtual                    ~text_buffer() = default;
+
+      virtual std::size_t        size() const = 0;
+      bool                       empty() const { return size() == 0; }
+      virtual char               at(std::size_t pos) const = 0;
+
+      virtual void               assign(std::string_view text) = 0;
+      virtual void               insert(std::size_t pos, std::string_view text) = 0;
+      virtual void               erase(std::size_t pos, std::size_t n) = 0;
+      virtual void               replace(std::size_t pos, std::size_t n, std::string_view text);
+      virtual std::string        substr(std::size_t pos, std::size_t n) const;
+
+      virtual std::string const& str() const = 0;
+      std::string_view           view() const { return str(); }
+
+      // UTF-8 cursors: the start of the next and previous code points
+      std::size_t                next_char(std::size_t pos) const;
+      std::size_t                prev_char(std::size_t pos) const;
+   };
+
+   using text_buffer_ptr = std::unique_ptr<text_buffer>;
+
+   ////////////////////////////////////////////////////////////////////////////
+   // string_buffer: The text in a single std::string. The snapshot is
+   // free. An edit moves the text after it.
+   ////////////////////////////////////////////////////////////////////////////
+   class string_buffer : public text_buffer
+   {
+   public:
+
+      explicit                   string_buffer(std::string_view text = "");
+
+      std::size_t                size() const override            { return _text.size(); }
+      char                       at(std::size_t pos) const override { return _text[pos]; }
+
+      void                       assign(std::string_view text) override;
+      void                       insert(std::size_t pos, std::string_view text) override;
+      void                       erase(std::size_t pos, std::size_t n) override;
+      void                       replace(std::size_t pos, std::size_t n, std::string_view text) override;
+      std::string                substr(std::size_t pos, std::size_t n) const override;
+
+      std::string const&         str() const override             { return _text; }
+
+   private:
+
+      std::string                _text;
+   };
+}}
+
+#endif
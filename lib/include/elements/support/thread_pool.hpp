@@ -0,0 +1,77 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_THREAD_POOL_OCTOBER_16_2019)
+#define ELEMENTS_THREAD_POOL_OCTOBER_16_2019
+
+#include <infra/support.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // thread_pool: A work-stealing pool of worker threads. Each worker has
+   // its own queue. Tasks submitted from a worker go to its own queue and
+   // other tasks are distributed round robin. An idle worker takes its
+   // most recent task first, then steals the oldest tasks of the others.
+   //
+   // Tasks should not throw: the pool drops their exceptions (view::async
+   // catches them and hands them to the view's thread). Pending tasks are
+   // completed before the pool is destroyed. The workers are started on
+   // the first submit, so an unused pool costs no threads.
+   ////////////////////////////////////////////////////////////////////////////
+   class thread_pool : non_copyable
+   {
+   public:
+
+      using task = std::function<void()>;
+
+      // The pool owned by the app registers itself as app_thread_pool()
+      enum application_tag { application };
+
+      explicit             thread_pool(std::size_t threads = 0);
+                           thread_pool(application_tag, std::size_t threads = 0);
+                           ~thread_pool();
+
+      void                 submit(task t);
+      std::size_t          size() const { return _queues.size(); }
+
+   private:
+
+      struct queue
+      {
+         std::mutex        mutex;
+         std::deque<task>  tasks;
+      };
+
+      void                 start();
+      void                 run(std::size_t index);
+      bool                 pop(std::size_t index, task& t);
+
+      std::vector<std::unique_ptr<queue>> _queues;
+      std::vector<std::thread> _threads;
+      std::once_flag       _started;
+      std::mutex           _mutex;
+      std::condition_variable _cv;
+      std::atomic<std::ptrdiff_t> _pending{ 0 };
+      std::atomic<std::size_t> _next{ 0 };
+      bool                 _stop = false;
+      bool                 _is_app_pool = false;
+   };
+
+   // The application's thread pool. Without an app (e.g. offscreen views),
+   // a pool is created on first use.
+   thread_pool& app_thread_pool();
+}}
+
+#endif
@@ -0,0 +1,91 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_TIMER_WHEEL_OCTOBER_16_2019)
+#define ELEMENTS_TIMER_WHEEL_OCTOBER_16_2019
+
+#include <infra/support.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // timer_wheel: A hierarchical timing wheel with a resolution of 1ms.
+   // Insertion, cancellation and expiry are O(1). Timers are kept in a pool
+   // that is reused, so there is no per-timer allocation once the pool has
+   // grown to the number of live timers (the callback itself may allocate
+   // if it does not fit std::function's small buffer).
+   //
+   // Expired timers are collected by advance and called by the client.
+   // timer_wheel is not thread safe.
+   ////////////////////////////////////////////////////////////////////////////
+   class timer_wheel : non_copyable
+   {
+   public:
+
+      using clock = std::chrono::steady_clock;
+      using time_point = clock::time_point;
+      using duration = std::chrono::milliseconds;
+      using function = std::function<void()>;
+      using function_list = std::vector<function>;
+
+      struct timer_id
+      {
+         std::uint32_t     index = 0;
+         std::uint32_t     generation = 0;     // 0 means no timer
+
+         explicit operator bool() const { return generation != 0; }
+      };
+
+      explicit             timer_wheel(time_point now = clock::now());
+
+      timer_id             add(time_point now, duration delay, function f);
+      bool                 cancel(timer_id id);
+
+      // Move the functions of all timers expired at time now to expired
+      void                 advance(time_point now, function_list& expired);
+
+      // The earliest time advance should be called, or time_point::max()
+      // if there are no timers.
+      time_point           next_expiry() const;
+      std::size_t          size() const { return _size; }
+
+   private:
+
+      static constexpr int levels = 4;
+      static constexpr int slot_bits = 6;
+      static constexpr int slots = 1 << slot_bits;
+      static constexpr std::uint32_t nil = std::uint32_t(-1);
+
+      struct node
+      {
+         function          f;
+         std::uint64_t     expiry = 0;             // in ticks
+         std::uint32_t     prev = nil;
+         std::uint32_t     next = nil;
+         std::uint32_t     generation = 1;
+         std::uint32_t     list = nil;             // index into _lists
+      };
+
+      std::uint64_t        ticks(time_point t) const;
+      void                 link(std::uint32_t i);
+      void                 unlink(std::uint32_t i);
+      void                 release(std::uint32_t i);
+      void                 cascade(int level);
+
+      time_point           _origin;
+      std::uint64_t        _current = 0;           // in ticks
+      std::size_t          _size = 0;
+      std::vector<node>    _nodes;
+      std::uint32_t        _free = nil;
+      std::array<std::uint32_t, levels * slots> _lists;
+   };
+}}
+
+#endif
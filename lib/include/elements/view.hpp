@@ -10,11 +10,21 @@
 #include <elements/support/rect.hpp>
 #include <elements/support/canvas.hpp>
 #include <elements/support/theme.hpp>
+#include <elements/support/parameter_channel.hpp>
+#include <elements/support/timer_wheel.hpp>
+#include <elements/support/animation.hpp>
+#include <elements/support/thread_pool.hpp>
+#include <elements/support/accelerator.hpp>
+#include <elements/support/render_cache.hpp>
 #include <elements/element/element.hpp>
 #include <elements/element/layer.hpp>
 #include <boost/asio.hpp>
+#include <deque>
+#include <exception>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 #include <chrono>
 
 namespace cycfi { namespace elements
@@ -48,12 +58,29 @@ namespace cycfi { namespace elements
       virtual void         refresh(rect area) override;
       void                 refresh(element& element, int outward = 0);
       void                 refresh(context const& ctx, int outward = 0);
-      rect                 dirty() const;
 
+      // True if area was repainted explicitly (refresh(rect)) in the frame
+      // being drawn. Unlike refresh(ctx), refresh(rect) does not say which
+      // element changed. A plain refresh() repaints the view without saying
+      // that anything changed.
+      bool                 is_repainted(rect area) const;
+      virtual bool         scroll_area(rect area, point offset) override;
+      using dirty_rects = std::vector<rect>;
+
+      rect                 dirty() const;
+      void                 dirty(rect area);
+      bool                 is_dirty(rect area) const;
+      dirty_rects const&   dirty_region() const;
+      void                 dirty_region(dirty_rects const& rects);
+
+      // size is the memory held by the task, counted against the undo
+      // budget. When the history exceeds the budget, the oldest tasks are
+      // dropped.
       struct undo_redo_task
       {
          std::function<void()> undo;
          std::function<void()> redo;
+         std::size_t       size = 0;
       };
 
       void                 add_undo(undo_redo_task t);
@@ -61,6 +88,8 @@ namespace cycfi { namespace elements
       bool                 has_redo();
       bool                 undo();
       bool                 redo();
+      std::size_t          undo_budget() const     { return _undo_budget; }
+      void                 undo_budget(std::size_t bytes);
 
       using content_type = layer_composite;
       using layers_type = layer_composite::container_type;
@@ -74,18 +103,113 @@ namespace cycfi { namespace elements
       view_limits          limits() const;
       mouse_button         current_button() const;
 
+      // An element that starts tracking the mouse on button-down captures
+      // the pointer. Drags then skip the elements that only forward them
+      // (see element::forwards_drag), using the context path recorded at
+      // capture time. The release goes through the tree, as usual, and
+      // ends the capture. Layout, scrolling, animations and refreshing the
+      // whole view (e.g. after switching a deck) drop the capture: the next
+      // drag goes through the tree again.
+      void                 capture_pointer(context const& ctx);
+      void                 release_pointer();
+      bool                 has_pointer_capture() const;
+
+      // The view records context paths to reach elements directly (the
+      // pointer capture and the elements of the parameter channels). Call
+      // this when elements moved without a layout (e.g. scrolling) to drop
+      // the recorded paths. Layout does it already.
+      void                 elements_moved();
+
       using change_limits_function = std::function<void(view_limits limits_)>;
       change_limits_function on_change_limits;
 
+      // Work posted directly to io() does not wake the view. Use post.
       using io_context = boost::asio::io_context;
       io_context&          io();
 
+      // Delayed calls are kept in a timer wheel and run from poll. They
+      // can be cancelled using the returned id.
+      using timer_id = timer_wheel::timer_id;
+
                            template <typename T, typename F>
-      void                 post(T duration, F f);
+      timer_id             post(T duration, F f);
+      bool                 cancel(timer_id id);
+      std::size_t          live_timers() const;
 
                            template <typename F>
       void                 post(F f);
 
+      // Animations are updated together, once per frame, and the view
+      // requests frames only while there are active animations. The
+      // element is refreshed after each update. Call these from the UI
+      // thread only.
+      using animation_id = animator::animation_id;
+
+      animation_id         animate(
+                              element& e, animator::duration d
+                            , animator::update_function f
+                            , easing::function ease = easing::ease_in_out
+                            , int property = animator::no_property
+                            , animator::done_function done = {}
+                           );
+
+                           template <typename E>
+      animation_id         animate_value(
+                              E& e, double to, animator::duration d
+                            , easing::function ease = easing::ease_in_out
+                           );
+
+      bool                 cancel_animation(animation_id id);
+      bool                 is_animating() const;
+
+      // Run work on the app's thread pool, then call on_done with its
+      // result on the view's thread. With an owner, the work is skipped
+      // and on_done is not called if the owner is destroyed first. If the
+      // work throws, on_done is called with the std::exception_ptr instead
+      // if it accepts one. Otherwise, the error is reported and the
+      // program is terminated: completions run from the host's event loop,
+      // which exceptions must not unwind through.
+                           template <typename Work, typename Done>
+      void                 async(Work work, Done on_done);
+
+                           template <typename Work, typename Done>
+      void                 async(element_ptr const& owner, Work work, Done on_done);
+
+      // Read the clipboard without blocking. Once its text is available,
+      // f is called with consecutive chunks of it, one chunk per frame,
+      // split at UTF-8 character boundaries. last is true for the final
+      // chunk, which is empty if the clipboard has no text. Nothing more is
+      // delivered once owner expires or the view is destroyed.
+      using clipboard_chunk_function = std::function<void(std::string_view chunk, bool last)>;
+      static constexpr std::size_t clipboard_chunk_size = 64 * 1024;
+
+      void                 paste_clipboard(std::weak_ptr<void> owner, clipboard_chunk_function f);
+
+      // Keyboard shortcuts. A key press not handled by the focused element
+      // is looked up here before it is offered to the other elements. An
+      // accelerator scoped to a layer of the view (e.g. a popup) is active
+      // only while the layer is open, and takes precedence over the global
+      // accelerators, topmost layer first.
+      using accelerator_id = accelerator_table::accelerator_id;
+      using accelerator_function = accelerator_table::function;
+
+      accelerator_id       add_accelerator(
+                              shortcut_key k, accelerator_function f
+                            , element const* scope = nullptr
+                           );
+      bool                 remove_accelerator(accelerator_id id);
+
+      // Called by the elements handling a key press, at most once per key
+      // press. Returns true if an accelerator handled the key.
+      bool                 accelerator(key_info const& k);
+
+      // Make a channel for pushing values into elements from another
+      // thread. Each producer thread should have its own channel. The
+      // view drains the channel until it is removed. Values pushed after
+      // that are ignored.
+      parameter_channel_ptr make_parameter_channel(std::size_t capacity = 1024);
+      bool                 remove_parameter_channel(parameter_channel_ptr const& ch);
+
       using tracking = element::tracking;
 
       using track_function = std::function<void(element& e, tracking state)>;
@@ -93,29 +217,126 @@ namespace cycfi { namespace elements
 
       void                 manage_on_tracking(element& e, tracking state);
 
+      // The view's retained pixmaps of static elements (see render_cache)
+      render_cache&        cache()                 { return _cache; }
+
    private:
 
       layer_composite      _content;
+      render_cache         _cache;
 
       bool                 set_limits();
+      void                 damage();
+      void                 damage(rect area);
+      void                 flush_damage();
+      void                 check_tracking();
+      void                 drain_parameters();
+      void                 run_timers();
+      void                 run_animations();
+      timer_id             add_timer(timer_wheel::duration delay, timer_wheel::function f);
 
       rect                 _dirty;
+      dirty_rects          _dirty_rects;
+
+      // Refresh requests are accumulated and flushed once per frame
+      std::mutex           _damage_mutex;
+      cairo_region_t*      _damage;
+      bool                 _damage_all = false;
+      cairo_region_t*      _repaint;
+
+      // The explicit repaints of the frame being drawn (see is_repainted)
+      cairo_region_t*      _frame_repaint;
+
+      // Persistent measurement context used for limits and event dispatch
+      cairo_surface_t*     _measure_surface;
+      cairo_t*             _measure_context;
       rect                 _current_bounds;
+
+      // The captured context path, root first. Drags start at
+      // _capture_start (see element::forwards_drag).
+      canvas               _capture_canvas{ *_measure_context };
+      std::vector<context> _pointer_capture;
+      std::size_t          _capture_start = 0;
       view_limits          _current_limits = { { 0, 0 }, { full_extent, full_extent} };
       mouse_button         _current_button;
       bool                 _is_focus = false;
 
-      using undo_stack_type = std::stack<undo_redo_task>;
+      accelerator_table    _accelerators;
+      bool                 _accelerator_tried = false;
+
+      void                 trim_undo();
+
+      using undo_stack_type = std::deque<undo_redo_task>;
       undo_stack_type      _undo_stack;
       undo_stack_type      _redo_stack;
+      std::size_t          _undo_size = 0;
+      std::size_t          _undo_budget = 16 * 1024 * 1024;
 
       io_context           _io;
       io_context::work     _work;
 
+      mutable std::mutex   _timers_mutex;
+      timer_wheel          _timers;
+      timer_wheel::time_point _timers_armed = timer_wheel::time_point::max();
+      timer_wheel::function_list _expired_timers;
+
+      animator             _animator;
+      animator::element_list _animated;
+
+      // Completions of async work are delivered through this. It is
+      // detached when the view is destroyed.
+      struct async_target
+      {
+                           async_target(view* target_)
+                            : target(target_)
+                           {}
+
+         std::mutex        mutex;
+         view*             target;
+      };
+
+                           template <typename Work, typename Done>
+      void                 async_impl(
+                              std::weak_ptr<element> owner, bool has_owner
+                            , Work work, Done on_done);
+
+      [[noreturn]] static void unhandled_async_error(std::exception_ptr error);
+
+      struct clipboard_paste
+      {
+         std::weak_ptr<void>        owner;
+         clipboard_chunk_function   f;
+         std::string                text;
+         std::size_t                pos = 0;
+      };
+
+      void                 paste_chunk(std::shared_ptr<clipboard_paste> p);
+
+      std::shared_ptr<async_target> _async_target = std::make_shared<async_target>(this);
+
+      using parameter_channels = std::vector<parameter_channel_ptr>;
+      parameter_channels   _parameter_channels;
+      element::element_list _parameter_targets;
+      element::element_list _parameter_unmapped;
+
+      // The recorded path to each parameter target: the elements along its
+      // context chain, root first, and its bounds. Elements not found in
+      // the tree have an empty path.
+      struct element_path
+      {
+         element::element_list elements;
+         rect              bounds;
+      };
+
+      using element_paths = std::unordered_map<element const*, element_path>;
+      element_paths        _parameter_paths;
+      bool                 _recording_paths = false;
+
       using time_point = std::chrono::steady_clock::time_point;
       element*             _tracking_element = nullptr;
       tracking             _tracking_state = tracking::none;
       time_point           _tracking_time;
+      bool                 _tracking_check = false;
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -126,6 +347,33 @@ namespace cycfi { namespace elements
       return _dirty;
    }
 
+   inline void view::dirty(rect area)
+   {
+      _dirty = area;
+      _dirty_rects.assign(1, area);
+   }
+
+   inline bool view::is_dirty(rect area) const
+   {
+      for (auto const& r : _dirty_rects)
+         if (intersects(area, r))
+            return true;
+      return false;
+   }
+
+   inline view::dirty_rects const& view::dirty_region() const
+   {
+      return _dirty_rects;
+   }
+
+   inline void view::dirty_region(dirty_rects const& rects)
+   {
+      _dirty_rects = rects;
+      _dirty = rect{};
+      for (auto const& r : rects)
+         _dirty = _dirty.is_empty()? r : max(_dirty, r);
+   }
+
    inline bool view::has_undo()
    {
       return !_undo_stack.empty();
@@ -156,7 +404,7 @@ namespace cycfi { namespace elements
             || std::find(_content.begin(), _content.end(), e) != _content.end())
             return;
 
-         io().post(
+         post(
             [e, this]
             {
                focus(focus_request::end_focus);
@@ -176,7 +424,7 @@ namespace cycfi { namespace elements
       // post a function that is called at idle time.
       if (e)
       {
-         io().post(
+         post(
             [e, this]
             {
                auto i = std::find(_content.begin(), _content.end(), e);
@@ -186,6 +434,7 @@ namespace cycfi { namespace elements
                   refresh(*e);
                   _content.erase(i);
                   _content.reset();
+                  _content.mark_dirty(element::all_dirty);
                   layout();
                   focus(focus_request::begin_focus);
                }
@@ -209,24 +458,123 @@ namespace cycfi { namespace elements
       return _current_button;
    }
 
+   inline void view::release_pointer()
+   {
+      _pointer_capture.clear();
+   }
+
+   inline bool view::has_pointer_capture() const
+   {
+      return !_pointer_capture.empty();
+   }
+
    template <typename T, typename F>
-   inline void view::post(T duration, F f)
+   inline view::timer_id view::post(T duration, F f)
+   {
+      return add_timer(
+         std::chrono::ceil<timer_wheel::duration>(duration), std::move(f));
+   }
+
+   template <typename Work, typename Done>
+   inline void view::async(element_ptr const& owner, Work work, Done on_done)
+   {
+      async_impl(owner, true, std::move(work), std::move(on_done));
+   }
+
+   template <typename Work, typename Done>
+   inline void view::async(Work work, Done on_done)
+   {
+      async_impl({}, false, std::move(work), std::move(on_done));
+   }
+
+   template <typename Work, typename Done>
+   inline void view::async_impl(
+      std::weak_ptr<element> owner, bool has_owner, Work work, Done on_done)
    {
-      auto timer = std::make_shared<boost::asio::steady_timer>(_io);
-      timer->expires_from_now(duration);
-      timer->async_wait(
-         [timer, f](auto const& err)
+      app_thread_pool().submit(
+         [target = _async_target, owner, has_owner, work, on_done]() mutable
          {
-            if (!err)
-               f();
+            auto cancelled = [owner, has_owner]
+            {
+               return has_owner && owner.expired();
+            };
+
+            // Skip the work if the owner is already gone
+            if (cancelled())
+               return;
+
+            std::function<void()> done;
+            try
+            {
+               if constexpr (std::is_void<decltype(work())>::value)
+               {
+                  work();
+                  done = [cancelled, on_done]() mutable
+                  {
+                     if (!cancelled())
+                        on_done();
+                  };
+               }
+               else
+               {
+                  done = [cancelled, on_done, r = work()]() mutable
+                  {
+                     if (!cancelled())
+                        on_done(std::move(r));
+                  };
+               }
+            }
+            catch (...)
+            {
+               done = [cancelled, on_done, error = std::current_exception()]() mutable
+               {
+                  if (cancelled())
+                     return;
+                  if constexpr (std::is_invocable<Done&, std::exception_ptr>::value)
+                     on_done(error);
+                  else
+                     unhandled_async_error(error);
+               };
+            }
+
+            // Deliver the completion to the view's thread, if the view is
+            // still around
+            std::lock_guard<std::mutex> lock(target->mutex);
+            if (target->target)
+               target->target->post(std::move(done));
          }
       );
    }
 
+   template <typename E>
+   inline view::animation_id view::animate_value(
+      E& e, double to, animator::duration d, easing::function ease)
+   {
+      // Tween element::value(double) from its current value
+      double from = e.value();
+      return animate(
+         e, d
+       , [&e, from, to](double t) { e.value(from + (to - from) * t); }
+       , ease, animator::value_property
+      );
+   }
+
+   inline bool view::is_animating() const
+   {
+      return _animator.active();
+   }
+
+   inline std::size_t view::live_timers() const
+   {
+      std::lock_guard<std::mutex> lock(_timers_mutex);
+      return _timers.size();
+   }
+
    template <typename F>
    inline void view::post(F f)
    {
       _io.post(f);
+      wake();
    }
 }}
 
@@ -0,0 +1,87 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/element/animated.hpp>
+#include <elements/support/context.hpp>
+#include <elements/view.hpp>
+
+namespace cycfi { namespace elements
+{
+   void animated_base::draw(context const& ctx)
+   {
+      _drawn_offset = _offset;
+      if (_opacity <= 0)
+      {
+         subject().clear_dirty(paint_dirty);
+         return;
+      }
+
+      if (_opacity >= 1)
+      {
+         proxy_base::draw(ctx);
+         return;
+      }
+
+      auto& cr = ctx.canvas.cairo_context();
+      cairo_push_group(&cr);
+      proxy_base::draw(ctx);
+      cairo_pop_group_to_source(&cr);
+      cairo_paint_with_alpha(&cr, _opacity);
+   }
+
+   void animated_base::refresh(context const& ctx, element& element, int outward)
+   {
+      // Refresh both where the subject was last drawn and where it will be
+      // drawn next
+      if (&element == this && outward == 0)
+      {
+         ctx.view.refresh(ctx.bounds.move(_drawn_offset.x, _drawn_offset.y));
+         ctx.view.refresh(ctx.bounds.move(_offset.x, _offset.y));
+      }
+      else
+      {
+         proxy_base::refresh(ctx, element, outward);
+      }
+   }
+
+   void animated_base::prepare_subject(context& ctx)
+   {
+      ctx.bounds = ctx.bounds.move(_offset.x, _offset.y);
+   }
+
+   animator::animation_id
+   animate_opacity(
+      view& view_, animated_base& e, float to, animator::duration d
+    , easing::function ease
+   )
+   {
+      auto from = e.opacity();
+      return view_.animate(
+         e, d
+       , [&e, from, to](double t) { e.opacity(from + (to - from) * t); }
+       , ease, animator::opacity_property
+      );
+   }
+
+   animator::animation_id
+   animate_offset(
+      view& view_, animated_base& e, point to, animator::duration d
+    , easing::function ease
+   )
+   {
+      auto from = e.offset();
+      return view_.animate(
+         e, d
+       , [&e, from, to](double t)
+         {
+            e.offset({
+               float(from.x + (to.x - from.x) * t)
+             , float(from.y + (to.y - from.y) * t)
+            });
+         }
+       , ease, animator::offset_property
+      );
+   }
+}}
@@ -0,0 +1,29 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/element/cache.hpp>
+#include <elements/support/context.hpp>
+#include <elements/view.hpp>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // cache_base class implementation
+   ////////////////////////////////////////////////////////////////////////////
+   void cache_base::draw(context const& ctx)
+   {
+      if (dirty() & paint_dirty)
+         subject().mark_dirty(paint_dirty);
+
+      context sctx { ctx, &subject(), ctx.bounds };
+      prepare_subject(sctx);
+      if (intersects(sctx.bounds, sctx.visible))
+      {
+         ctx.view.cache().draw(sctx, subject(), render_cache::always);
+         subject().clear_dirty(paint_dirty);
+      }
+      restore_subject(sctx);
+   }
+}}
@@ -6,6 +6,7 @@
 #include <elements/element/composite.hpp>
 #include <elements/support/context.hpp>
 #include <elements/view.hpp>
+#include <algorithm>
 
 namespace cycfi { namespace elements
 {
@@ -33,14 +34,16 @@ namespace cycfi { namespace elements
 
    void composite_base::draw(context const& ctx)
    {
-      for (std::size_t ix = 0; ix < size(); ++ix)
+      auto range = range_of(ctx, ctx.visible);
+      for (std::size_t ix = range.first; ix < range.last; ++ix)
       {
          rect bounds = bounds_of(ctx, ix);
-         if (intersects(bounds, ctx.view.dirty()))
+         if (intersects(bounds, ctx.visible) && ctx.view.is_dirty(bounds))
          {
             auto& e = at(ix);
             context ectx{ ctx, &e, bounds };
-            e.draw(ectx);
+            ctx.view.cache().draw(ectx, e);
+            e.clear_dirty(paint_dirty);
          }
       }
    }
@@ -63,6 +66,24 @@ namespace cycfi { namespace elements
       }
    }
 
+   void composite_base::refresh(context const& ctx, element_list const& elements)
+   {
+      if (std::binary_search(elements.begin(), elements.end(), this))
+      {
+         refresh(ctx, *this);
+      }
+      else
+      {
+         for (std::size_t ix = 0; ix < size(); ++ix)
+         {
+            rect bounds = bounds_of(ctx, ix);
+            auto& e = at(ix);
+            context ectx{ ctx, &e, bounds };
+            e.refresh(ectx, elements);
+         }
+      }
+   }
+
    element* composite_base::click(context const& ctx, mouse_button btn)
    {
       point p = btn.pos;
@@ -111,14 +132,14 @@ namespace cycfi { namespace elements
    void composite_base::new_focus(context const& ctx, int index)
    {
       // end the previous focus
-      if (_focus != -1)
+      if (_focus != -1 && _focus < int(size()))
       {
          at(_focus).focus(focus_request::end_focus);
          ctx.view.refresh(ctx);
       }
 
       // start a new focus
-      _focus = index;
+      _focus = (index < int(size()))? index : -1;
       if (_focus != -1)
       {
          at(_focus).focus(focus_request::begin_focus);
@@ -133,17 +154,17 @@ namespace cycfi { namespace elements
          rect bounds = bounds_of(ctx, ix);
          auto& e = at(ix);
          context ectx{ ctx, &e, bounds };
-         return e.key(ectx, k);
-      };
+         if (k.count <= 1 || e.handles_repeat_count())
+            return e.key(ectx, k);
 
-      auto&& try_focus = [&](auto ix) -> bool
-      {
-         if (at(ix).focus(focus_request::wants_focus))
-         {
-            new_focus(ctx, ix);
-            return true;
-         }
-         return false;
+         // Replay the folded key repeats one at a time
+         auto k1 = k;
+         k1.count = 1;
+         if (!e.key(ectx, k1))
+            return false;
+         for (int i = 1; i < k.count; ++i)
+            e.key(ectx, k1);
+         return true;
       };
 
       if (_focus != -1)
@@ -155,27 +176,27 @@ namespace cycfi { namespace elements
       if ((k.action == key_action::press || k.action == key_action::repeat)
          && k.key == key_code::tab && size())
       {
-         auto next_focus = _focus;
-         bool reverse = (k.modifiers & mod_shift) ^ reverse_index();
-         if ((next_focus == -1) || !reverse)
+         // Move the focus once per key repeat, up to the end of the
+         // chain
+         bool moved = false;
+         for (int n = std::max(k.count, 1); n != 0; --n)
          {
-            while (++next_focus != size())
-               if (try_focus(next_focus))
-                  return true;
-            return false;
-         }
-         else
-         {
-            while (--next_focus >= 0)
-               if (at(next_focus).focus(focus_request::wants_focus))
-                  if (try_focus(next_focus))
-                     return true;
-            return false;
+            bool reverse = (k.modifiers & mod_shift) ^ reverse_index();
+            auto next = next_focus(_focus, reverse && _focus != -1);
+            if (next == -1)
+               break;
+            new_focus(ctx, next);
+            moved = true;
          }
+         return moved;
       }
 
       // If we reached here, then there's either no focus, or the
-      // focus did not handle the key press.
+      // focus did not handle the key press. Try the view's accelerators
+      // before offering the key to all the elements.
+      if (ctx.view.accelerator(k))
+         return true;
+
       if (reverse_index())
       {
          for (int ix = int(size())-1; ix >= 0; --ix)
@@ -203,7 +224,17 @@ namespace cycfi { namespace elements
          rect  bounds = bounds_of(ctx, _focus);
          auto& focus_ = at(_focus);
          context ectx{ ctx, &focus_, bounds };
-         return focus_.text(ectx, info);
+         if (info.count <= 1 || focus_.handles_repeat_count())
+            return focus_.text(ectx, info);
+
+         // Replay the folded entries one at a time
+         auto info1 = info;
+         info1.count = 1;
+         if (!focus_.text(ectx, info1))
+            return false;
+         for (int i = 1; i < info.count; ++i)
+            focus_.text(ectx, info1);
+         return true;
       };
 
       return false;
@@ -272,29 +303,22 @@ namespace cycfi { namespace elements
       switch (r)
       {
          case focus_request::wants_focus:
-            for (std::size_t ix = 0; ix != size(); ++ix)
-               if (at(ix).focus(focus_request::wants_focus))
-                  return true;
-            return false;
+            return next_focus(-1, false) != -1;
 
          case focus_request::begin_focus:
             if (_focus == -1)
                _focus = _saved_focus;
+            // The elements may have changed since the focus was saved
+            if (_focus >= int(size()))
+               _focus = -1;
             if (_focus == -1)
-            {
-               for (std::size_t ix = 0; ix != size(); ++ix)
-                  if (at(ix).focus(focus_request::wants_focus))
-                  {
-                     _focus = ix;
-                     break;
-                  }
-            }
+               _focus = next_focus(-1, false);
             if (_focus != -1)
                at(_focus).focus(focus_request::begin_focus);
             return true;
 
          case focus_request::end_focus:
-            if (_focus != -1)
+            if (_focus != -1 && _focus < int(size()))
                at(_focus).focus(focus_request::end_focus);
             _saved_focus = _focus;
             _focus = -1;
@@ -304,6 +328,56 @@ namespace cycfi { namespace elements
       return false;
    }
 
+   composite_base::focus_chain_type const& composite_base::focus_chain()
+   {
+      // Elements not yet laid out may still change, so the chain is only
+      // kept once the layout is clean. Elements may also be added or
+      // removed without invalidating the composite.
+      if (!_focus_chain_valid
+         || _focus_chain_size != size()
+         || (dirty() & (limits_dirty | layout_dirty | focus_dirty)))
+      {
+         _focus_chain.clear();
+         for (std::size_t ix = 0; ix != size(); ++ix)
+            if (at(ix).focus(focus_request::wants_focus))
+               _focus_chain.push_back(int(ix));
+         _focus_chain_size = size();
+         _focus_chain_valid = true;
+         clear_dirty(focus_dirty);
+      }
+      return _focus_chain;
+   }
+
+   int composite_base::next_focus(int index, bool reverse)
+   {
+      // Returns the element of the focus chain after index (or before it,
+      // if reverse), or -1 if there is none. An element may stop wanting
+      // the focus without invalidating us. Such elements are skipped, and
+      // the chain is rebuilt next time.
+      auto const& chain = focus_chain();
+      auto wants_focus = [this](int ix)
+      {
+         if (at(ix).focus(focus_request::wants_focus))
+            return true;
+         _focus_chain_valid = false;
+         return false;
+      };
+
+      if (!reverse)
+      {
+         for (auto i = std::upper_bound(chain.begin(), chain.end(), index); i != chain.end(); ++i)
+            if (wants_focus(*i))
+               return *i;
+      }
+      else
+      {
+         for (auto i = std::lower_bound(chain.begin(), chain.end(), index); i != chain.begin();)
+            if (wants_focus(*--i))
+               return *i;
+      }
+      return -1;
+   }
+
    element const* composite_base::focus() const
    {
       return (empty() || (_focus == -1))? 0 : &at(_focus);
@@ -322,7 +396,8 @@ namespace cycfi { namespace elements
 
    composite_base::hit_info composite_base::hit_element(context const& ctx, point p) const
    {
-      for (std::size_t ix = 0; ix < size(); ++ix)
+      auto range = range_of(ctx, rect{ p.x, p.y, p.x, p.y });
+      for (std::size_t ix = range.first; ix < range.last; ++ix)
       {
          auto& e = at(ix);
          if (e.is_control())
@@ -339,6 +414,14 @@ namespace cycfi { namespace elements
       return hit_info{ 0, rect{}, -1 };
    }
 
+   composite_base::index_range
+   composite_base::range_of(context const& ctx, rect area) const
+   {
+      // By default, all the elements are candidates. Composites that know
+      // where their elements are (e.g. tiles) narrow this down.
+      return { 0, size() };
+   }
+
    bool composite_base::is_control() const
    {
       for (std::size_t ix = 0; ix < size(); ++ix)
@@ -347,6 +430,53 @@ namespace cycfi { namespace elements
       return false;
    }
 
+   bool composite_base::handles_repeat_count() const
+   {
+      // We replay the repeats to the elements that do not handle them
+      return true;
+   }
+
+   bool composite_base::forwards_drag() const
+   {
+      // Composites that drag on their own should return false
+      return true;
+   }
+
+   void composite_base::layout_element(context const& ctx, std::size_t index, rect bounds)
+   {
+      auto& e = at(index);
+      e.clear_dirty(limits_dirty | layout_dirty);
+      e.layout(context{ ctx, &e, bounds });
+   }
+
+   bool composite_base::invalidate(element const* e, int what)
+   {
+      // An element is in one place only: stop at the element that has it.
+      // Check the elements themselves first (e.g. a popup in the view's
+      // content), before searching inside each of them.
+      bool found = false;
+      if (e)
+      {
+         for (std::size_t ix = 0; !found && ix < size(); ++ix)
+            found = &at(ix) == e && at(ix).invalidate(e, what);
+         for (std::size_t ix = 0; !found && ix < size(); ++ix)
+            found = at(ix).invalidate(e, what);
+      }
+      else
+      {
+         for (std::size_t ix = 0; ix < size(); ++ix)
+            found = at(ix).invalidate(e, what) || found;
+      }
+      bool result = found?
+         element::invalidate(nullptr, what) : element::invalidate(e, what);
+
+      // Elements in the path may have been added or removed, or may have
+      // changed their minds about the focus
+      if (result && (what & (layout_dirty | focus_dirty)))
+         _focus_chain_valid = false;
+      return result;
+   }
+
    void composite_base::reset()
    {
       _focus = -1;
@@ -354,5 +484,6 @@ namespace cycfi { namespace elements
       _drag_tracking = -1;
       _click_info = hit_info{};
       _cursor_info = hit_info{};
+      _focus_chain_valid = false;
    }
 }}
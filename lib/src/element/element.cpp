@@ -6,12 +6,43 @@
 #include <elements/element/element.hpp>
 #include <elements/support.hpp>
 #include <elements/view.hpp>
+#include <algorithm>
 
 namespace cycfi { namespace elements
 {
    ////////////////////////////////////////////////////////////////////////////
    // element class implementation
    ////////////////////////////////////////////////////////////////////////////
+   element::~element()
+   {
+      render_cache::flush(*this);
+   }
+
+   // The cached pixmap belongs to the element it was rendered from. Copies
+   // render their own.
+   element::element(element&& rhs)
+    : _dirty(rhs._dirty)
+   {}
+
+   element::element(element const& rhs)
+    : _dirty(rhs._dirty)
+   {}
+
+   element& element::operator=(element&& rhs)
+   {
+      return *this = static_cast<element const&>(rhs);
+   }
+
+   element& element::operator=(element const& rhs)
+   {
+      if (this != &rhs)
+      {
+         render_cache::flush(*this);
+         _dirty = rhs._dirty;
+      }
+      return *this;
+   }
+
    view_limits element::limits(basic_context const& ctx) const
    {
       return full_limits;
@@ -41,6 +72,12 @@ namespace cycfi { namespace elements
          ctx.view.refresh(ctx, outward);
    }
 
+   void element::refresh(context const& ctx, element_list const& elements)
+   {
+      if (std::binary_search(elements.begin(), elements.end(), this))
+         refresh(ctx, *this);
+   }
+
    element* element::click(context const& ctx, mouse_button btn)
    {
       return nullptr;
@@ -90,6 +127,16 @@ namespace cycfi { namespace elements
       return false;
    }
 
+   bool element::handles_repeat_count() const
+   {
+      return false;
+   }
+
+   bool element::forwards_drag() const
+   {
+      return false;
+   }
+
    void element::value(bool val)
    {
    }
@@ -106,8 +153,45 @@ namespace cycfi { namespace elements
    {
    }
 
+   void element::invalidate(context const& ctx, int what)
+   {
+      // A change in limits always requires a new layout
+      if (what & limits_dirty)
+         what |= layout_dirty;
+
+      // Mark this element and all the elements along the context chain
+      _dirty |= what;
+      context const* root = &ctx;
+      for (auto p = &ctx; p; p = p->parent)
+      {
+         if (p->element)
+            p->element->_dirty |= what;
+         root = p;
+      }
+
+      // The root context may not be the view's content (e.g. popups are
+      // laid out using their own context). Locate it from the content.
+      auto& content = ctx.view.content();
+      if (root->element && root->element != &content)
+         content.invalidate(root->element, what);
+   }
+
+   bool element::invalidate(element const* e, int what)
+   {
+      if (e && e != this)
+         return false;
+      if (what & limits_dirty)
+         what |= layout_dirty;
+      _dirty |= what;
+      return true;
+   }
+
    void element::on_tracking(context const& ctx, tracking state)
    {
+      // Tracking elements capture the pointer. This also captures it again
+      // after the capture was dropped mid-drag.
+      if (state != end_tracking)
+         ctx.view.capture_pointer(ctx);
       ctx.view.manage_on_tracking(*this, state);
    }
 }}
@@ -21,9 +21,14 @@ namespace cycfi { namespace elements
 
    void flow_element::layout(context const& ctx)
    {
+      auto num_rows = size();
       clear();
       _flowable.break_lines(*this, ctx, ctx.bounds.width());
       base_type::layout(ctx);
+
+      // Our limits depend on the number of rows
+      if (!_laid_out || num_rows != size())
+         invalidate(ctx, limits_dirty);
       _laid_out = true;
    }
 
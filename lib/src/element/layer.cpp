@@ -6,6 +6,7 @@
 #include <elements/element/layer.hpp>
 #include <elements/view.hpp>
 #include <elements/support/context.hpp>
+#include <algorithm>
 
 namespace cycfi { namespace elements
 {
@@ -33,11 +34,14 @@ namespace cycfi { namespace elements
 
    void layer_element::layout(context const& ctx)
    {
+      // Layout all the elements if our bounds changed. Otherwise, only the
+      // elements that were invalidated are laid out.
+      bool relayout = bounds != ctx.bounds;
       bounds = ctx.bounds;
       for (std::size_t ix = 0; ix != size(); ++ix)
       {
-         auto& e = at(ix);
-         e.layout(context{ ctx, &e, bounds_of(ctx, ix) });
+         if (relayout || (at(ix).dirty() & layout_dirty))
+            layout_element(ctx, ix, bounds_of(ctx, ix));
       }
    }
 
@@ -105,11 +109,12 @@ namespace cycfi { namespace elements
    void deck_element::draw(context const& ctx)
    {
       rect bounds = bounds_of(ctx, _selected_index);
-      if (intersects(bounds, ctx.view.dirty()))
+      if (intersects(bounds, ctx.visible) && ctx.view.is_dirty(bounds))
       {
          auto& elem = at(_selected_index);
          context ectx{ ctx, &elem, bounds };
-         elem.draw(ectx);
+         ctx.view.cache().draw(ectx, elem);
+         elem.clear_dirty(paint_dirty);
       }
    }
 
@@ -128,6 +133,21 @@ namespace cycfi { namespace elements
       }
    }
 
+   void deck_element::refresh(context const& ctx, element_list const& elements)
+   {
+      if (std::binary_search(elements.begin(), elements.end(), this))
+      {
+         refresh(ctx, *this);
+      }
+      else
+      {
+         rect bounds = bounds_of(ctx, _selected_index);
+         auto& elem = at(_selected_index);
+         context ectx{ ctx, &elem, bounds };
+         elem.refresh(ectx, elements);
+      }
+   }
+
    layer_element::hit_info deck_element::hit_element(context const& ctx, point p) const
    {
       auto& e = at(_selected_index);
@@ -55,9 +55,101 @@ namespace cycfi { namespace elements
 
       context new_ctx{ ctx.view, ctx.canvas, _popup.get(), bounds };
       _popup->bounds(bounds);
+      _popup->clear_dirty(limits_dirty | layout_dirty);
       _popup->layout(new_ctx);
    }
 
+   namespace
+   {
+      template <typename F>
+      void for_each_menu_item(element& e, F&& f)
+      {
+         if (auto item = dynamic_cast<basic_menu_item_element*>(&e))
+         {
+            f(*item);
+         }
+         else if (auto proxy = dynamic_cast<proxy_base*>(&e))
+         {
+            for_each_menu_item(proxy->subject(), f);
+         }
+         else if (auto c = dynamic_cast<composite_base*>(&e))
+         {
+            for (std::size_t i = 0; i != c->size(); ++i)
+               for_each_menu_item(c->at(i), f);
+         }
+      }
+   }
+
+   basic_menu::accelerators&
+   basic_menu::accelerators::operator=(accelerators const&)
+   {
+      remove();
+      return *this;
+   }
+
+   void basic_menu::accelerators::remove()
+   {
+      if (view_)
+      {
+         for (auto id : ids)
+            view_->remove_accelerator(id);
+      }
+      ids.clear();
+      view_ = nullptr;
+   }
+
+   void basic_menu::add_accelerators(view& view_)
+   {
+      _accelerators.remove();
+
+      // The menu and its items are held weakly: accelerators of elements
+      // that are gone are dropped by the view.
+      std::weak_ptr<element> menu = weak_from_this();
+      if (menu.expired())
+         return;
+
+      for_each_menu_item(*_popup,
+         [&](basic_menu_item_element& item_)
+         {
+            if (item_.shortcut.key == key_code::unknown)
+               return;
+
+            std::weak_ptr<element> item = item_.weak_from_this();
+            if (item.expired())
+               return;
+
+            auto id = view_.add_accelerator(item_.shortcut,
+               [menu, item, &view_]() -> bool
+               {
+                  auto menu_ = std::static_pointer_cast<basic_menu>(menu.lock());
+                  auto item_ = std::static_pointer_cast<basic_menu_item_element>(item.lock());
+                  if (!menu_ || !item_)
+                     return false;
+
+                  if (item_->on_click)
+                     item_->on_click();
+                  if (menu_->value())
+                  {
+                     menu_->_popup->close(view_);
+                     menu_->state(false);
+                  }
+                  view_.refresh();
+                  return true;
+               }
+            );
+            _accelerators.ids.push_back(id);
+         }
+      );
+      _accelerators.view_ = &view_;
+   }
+
+   void basic_menu::layout(context const& ctx)
+   {
+      layered_button::layout(ctx);
+      if (_popup && _accelerators.view_ != &ctx.view)
+         add_accelerators(ctx.view);
+   }
+
    element* basic_menu::click(context const& ctx, mouse_button btn)
    {
       if (btn.down)
@@ -107,6 +199,11 @@ namespace cycfi { namespace elements
       if (!_popup)
          return false;
 
+      // The shortcuts of a closed menu are handled by the view's
+      // accelerators
+      if (_accelerators.view_ == &ctx.view && !value())
+         return layered_button::key(ctx, k);
+
       // simulate a menu key:
       rect bounds = _popup->bounds();
       context new_ctx{ ctx.view, ctx.canvas, _popup.get(), bounds };
@@ -332,7 +429,10 @@ namespace cycfi { namespace elements
             }
          }
          select(hit);
-         ctx.view.refresh();
+
+         // The selection changed: refresh the menu items (not just the
+         // view) so that a cached menu is rendered again.
+         ctx.view.refresh(c? *cctx : ctx);
       }
       proxy_base::cursor(ctx, p, status);
       return hit;
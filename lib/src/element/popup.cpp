@@ -15,6 +15,30 @@ namespace cycfi { namespace elements
       return element::hit_test(ctx, p);
    }
 
+   void basic_popup_element::draw(context const& ctx)
+   {
+      if (_opacity >= 1)
+      {
+         floating_element::draw(ctx);
+         return;
+      }
+
+      auto& cr = ctx.canvas.cairo_context();
+      cairo_push_group(&cr);
+      floating_element::draw(ctx);
+      cairo_pop_group_to_source(&cr);
+      cairo_paint_with_alpha(&cr, _opacity);
+   }
+
+   void basic_popup_element::refresh(context const& ctx, element& element, int outward)
+   {
+      // A popup draws only within its floating bounds
+      if (&element == this && outward == 0)
+         ctx.view.refresh(bounds());
+      else
+         floating_element::refresh(ctx, element, outward);
+   }
+
    element* basic_popup_element::click(context const& ctx, mouse_button btn)
    {
       bool hit = false;
@@ -46,10 +70,19 @@ namespace cycfi { namespace elements
    {
       view_.add(shared_from_this());
       _on_click = on_click;
+
+      using namespace std::chrono_literals;
+      _opacity = 0;
+      view_.animate(
+         *this, 150ms
+       , [this, self = shared_from_this()](double t) { _opacity = t; }
+       , easing::ease_out, animator::opacity_property
+      );
    }
 
    void basic_popup_element::close(view& view_)
    {
+      _opacity = 1;
       view_.remove(shared_from_this());
    }
 }}
@@ -23,7 +23,13 @@ namespace cycfi { namespace elements
 
    void port_base::prepare_subject(context& ctx)
    {
-      view_limits    e_limits          = subject().limits(ctx);
+      // The subject's limits are computed again only if it was invalidated
+      auto&          e                 = subject();
+      bool           dirty             = !_subject_valid || (e.dirty() & (limits_dirty | layout_dirty));
+      if (dirty)
+         _subject_limits = e.limits(ctx);
+
+      view_limits    e_limits          = _subject_limits;
       double         elem_width        = e_limits.min.x;
       double         elem_height       = e_limits.min.y;
       double         available_width   = ctx.parent->bounds.width();
@@ -34,7 +40,14 @@ namespace cycfi { namespace elements
       ctx.bounds.top -= (elem_height - available_height) * _valign;
       ctx.bounds.height(elem_height);
 
-      subject().layout(ctx);
+      // ... and laid out again only if it was invalidated or moved
+      if (dirty || ctx.bounds != _subject_bounds)
+      {
+         _subject_bounds = ctx.bounds;
+         _subject_valid = true;
+         e.clear_dirty(limits_dirty | layout_dirty);
+         e.layout(ctx);
+      }
    }
 
    void port_base::draw(context const& ctx)
@@ -42,7 +55,11 @@ namespace cycfi { namespace elements
       auto state = ctx.canvas.new_state();
       ctx.canvas.rect(ctx.bounds);
       ctx.canvas.clip();
-      proxy_base::draw(ctx);
+
+      // Nothing outside our bounds is visible
+      context cctx{ ctx, ctx.bounds };
+      cctx.visible = min(ctx.visible, ctx.bounds);
+      proxy_base::draw(cctx);
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -56,14 +73,26 @@ namespace cycfi { namespace elements
 
    void vport_base::prepare_subject(context& ctx)
    {
-      view_limits    e_limits          = subject().limits(ctx);
-      double         elem_height       = e_limits.min.y;
+      // The subject's limits are computed again only if it was invalidated
+      auto&          e                 = subject();
+      bool           dirty             = !_subject_valid || (e.dirty() & (limits_dirty | layout_dirty));
+      if (dirty)
+         _subject_limits = e.limits(ctx);
+
+      double         elem_height       = _subject_limits.min.y;
       double         available_height  = ctx.parent->bounds.height();
 
       ctx.bounds.top -= (elem_height - available_height) * _valign;
       ctx.bounds.height(elem_height);
 
-      subject().layout(ctx);
+      // ... and laid out again only if it was invalidated or moved
+      if (dirty || ctx.bounds != _subject_bounds)
+      {
+         _subject_bounds = ctx.bounds;
+         _subject_valid = true;
+         e.clear_dirty(limits_dirty | layout_dirty);
+         e.layout(ctx);
+      }
    }
 
    void vport_base::draw(context const& ctx)
@@ -71,7 +100,11 @@ namespace cycfi { namespace elements
       auto state = ctx.canvas.new_state();
       ctx.canvas.rect(ctx.bounds);
       ctx.canvas.clip();
-      proxy_base::draw(ctx);
+
+      // Nothing outside our bounds is visible
+      context cctx{ ctx, ctx.bounds };
+      cctx.visible = min(ctx.visible, ctx.bounds);
+      proxy_base::draw(cctx);
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -249,38 +282,134 @@ namespace cycfi { namespace elements
       }
    }
 
+   namespace
+   {
+      // Scroll by whole pixels so that the contents can be moved by
+      // blitting. The fraction left over is kept in remainder and added to
+      // the next delta in the same direction.
+      double whole_pixels(double delta, float& remainder)
+      {
+         if (delta == 0)
+            return 0;
+         if ((delta > 0) != (remainder > 0))
+            remainder = 0;
+         double total = delta + remainder;
+         double px = std::trunc(total);
+         remainder = float(total - px);
+         return px;
+      }
+
+      // Snap an alignment so that the contents are at a whole pixel
+      // position. extent is the scrollable range, in pixels.
+      double snap_align(double align, double extent)
+      {
+         if (extent > 0)
+            align = std::round(align * extent) / extent;
+         clamp(align, 0.0, 1.0);
+         return align;
+      }
+
+      // Alignments at whole pixels move the contents by whole pixels, give
+      // or take rounding errors
+      float snap_offset(double offset)
+      {
+         double px = std::round(offset);
+         return float((std::abs(offset - px) < 1e-3)? px : offset);
+      }
+   }
+
    bool scroller_base::scroll(context const& ctx, point dir, point p)
    {
       view_limits e_limits = subject().limits(ctx);
       bool redraw = false;
+      bool handled = false;   // scrolled, or less than a pixel
+      double old_halign = halign();
+      double old_valign = valign();
 
       if (allow_hscroll())
       {
-         double dx = (-dir.x / (e_limits.min.x - ctx.bounds.width()));
-         if ((dx > 0 && halign() < 1.0) || (dx < 0 && halign() > 0.0))
+         double extent = e_limits.min.x - ctx.bounds.width();
+         double dx = whole_pixels(-dir.x, _scroll_remainder.x);
+         if ((dir.x < 0 && halign() < 1.0) || (dir.x > 0 && halign() > 0.0))
          {
-            double alx = halign() + dx;
-            clamp(alx, 0.0, 1.0);
-            halign(alx);
-            redraw = true;
+            if (dx != 0)
+            {
+               double alx = halign() + dx / extent;
+               clamp(alx, 0.0, 1.0);
+               halign(alx);
+               redraw = true;
+            }
+            handled = true;
+         }
+         else
+         {
+            _scroll_remainder.x = 0;
          }
       }
 
       if (allow_vscroll())
       {
-         double dy = (-dir.y / (e_limits.min.y - ctx.bounds.height()));
-         if ((dy > 0 && valign() < 1.0) || (dy < 0 && valign() > 0.0))
+         double extent = e_limits.min.y - ctx.bounds.height();
+         double dy = whole_pixels(-dir.y, _scroll_remainder.y);
+         if ((dir.y < 0 && valign() < 1.0) || (dir.y > 0 && valign() > 0.0))
          {
-            double aly = valign() + dy;
-            clamp(aly, 0.0, 1.0);
-            valign(aly);
-            redraw = true;
+            if (dy != 0)
+            {
+               double aly = valign() + dy / extent;
+               clamp(aly, 0.0, 1.0);
+               valign(aly);
+               redraw = true;
+            }
+            handled = true;
+         }
+         else
+         {
+            _scroll_remainder.y = 0;
          }
       }
 
       if (redraw)
+         scrolled(ctx, old_halign, old_valign);
+      return handled;
+   }
+
+   void scroller_base::scrolled(context const& ctx, double old_halign, double old_valign)
+   {
+      // The contents moved: the recorded context paths are stale
+      ctx.view.elements_moved();
+
+      view_limits e_limits = subject().limits(ctx);
+      point offset = {
+         snap_offset((old_halign - halign()) * (e_limits.min.x - ctx.bounds.width())),
+         snap_offset((old_valign - valign()) * (e_limits.min.y - ctx.bounds.height()))
+      };
+
+      // The visible part of our port: our bounds clipped by the
+      // enclosing ports
+      rect area = ctx.bounds;
+      for (auto p = ctx.parent; p; p = p->parent)
+      {
+         if (dynamic_cast<port_base*>(p->element) || dynamic_cast<vport_base*>(p->element))
+            area = min(area, p->bounds);
+      }
+
+      // Move the pixels we already have and refresh only the exposed
+      // parts and the scroll bars. If the view can't, refresh everything.
+      invalidate(ctx, paint_dirty);
+      if (!ctx.view.scroll_area(area, offset))
+      {
          ctx.view.refresh(ctx);
-      return redraw;
+         return;
+      }
+
+      if (has_scrollbars())
+      {
+         scrollbar_bounds sb = get_scrollbar_bounds(ctx);
+         if (sb.has_v)
+            ctx.view.refresh(sb.vscroll_bounds);
+         if (sb.has_h)
+            ctx.view.refresh(sb.hscroll_bounds);
+      }
    }
 
    element* scroller_base::click(context const& ctx, mouse_button btn)
@@ -330,18 +459,22 @@ namespace cycfi { namespace elements
       scrollbar_bounds  sb = get_scrollbar_bounds(ctx);
       view_limits       e_limits = subject().limits(ctx);
 
+      // The thumb moves the contents by whole pixels, so that they can be
+      // moved by blitting (see scrolled)
       auto valign_ = [&](double align)
       {
-         clamp(align, 0.0, 1.0);
+         align = snap_align(align, e_limits.min.y - ctx.bounds.height());
+         double old_valign = valign();
          valign(align);
-         ctx.view.refresh(ctx);
+         scrolled(ctx, halign(), old_valign);
       };
 
       auto halign_ = [&](double align)
       {
-         clamp(align, 0.0, 1.0);
+         align = snap_align(align, e_limits.min.x - ctx.bounds.width());
+         double old_halign = halign();
          halign(align);
-         ctx.view.refresh(ctx);
+         scrolled(ctx, old_halign, valign());
       };
 
       if (sb.has_v)
@@ -431,8 +564,12 @@ namespace cycfi { namespace elements
    {
       if (has_scrollbars())
       {
-         ctx.view.refresh(ctx);
+         // Only the scroll bars track the cursor
          scrollbar_bounds sb = get_scrollbar_bounds(ctx);
+         if (sb.has_v)
+            ctx.view.refresh(sb.vscroll_bounds);
+         if (sb.has_h)
+            ctx.view.refresh(sb.hscroll_bounds);
          if (sb.hscroll_bounds.includes(p) || sb.vscroll_bounds.includes(p))
          {
             set_cursor(cursor_type::arrow);
@@ -6,6 +6,7 @@
 #include <elements/element/proxy.hpp>
 #include <elements/support/context.hpp>
 #include <elements/view.hpp>
+#include <algorithm>
 
 namespace cycfi { namespace elements
 {
@@ -35,7 +36,11 @@ namespace cycfi { namespace elements
    {
       context sctx { ctx, &subject(), ctx.bounds };
       prepare_subject(sctx);
-      subject().draw(sctx);
+      if (intersects(sctx.bounds, sctx.visible))
+      {
+         subject().draw(sctx);
+         subject().clear_dirty(paint_dirty);
+      }
       restore_subject(sctx);
    }
 
@@ -43,6 +48,7 @@ namespace cycfi { namespace elements
    {
       context sctx { ctx, &subject(), ctx.bounds };
       prepare_subject(sctx);
+      subject().clear_dirty(limits_dirty | layout_dirty);
       subject().layout(sctx);
       restore_subject(sctx);
    }
@@ -62,6 +68,21 @@ namespace cycfi { namespace elements
       }
    }
 
+   void proxy_base::refresh(context const& ctx, element_list const& elements)
+   {
+      if (std::binary_search(elements.begin(), elements.end(), this))
+      {
+         refresh(ctx, *this);
+      }
+      else
+      {
+         context sctx { ctx, &subject(), ctx.bounds };
+         prepare_subject(sctx);
+         subject().refresh(sctx, elements);
+         restore_subject(sctx);
+      }
+   }
+
    void proxy_base::prepare_subject(context& ctx)
    {
    }
@@ -148,6 +169,19 @@ namespace cycfi { namespace elements
       return subject().is_control();
    }
 
+   bool proxy_base::handles_repeat_count() const
+   {
+      // Proxies that handle keys themselves should return false
+      return subject().handles_repeat_count();
+   }
+
+   bool proxy_base::forwards_drag() const
+   {
+      // Proxies that drag on their own, or that move the mouse position
+      // (prepare_subject(ctx, p)), should return false
+      return true;
+   }
+
    void proxy_base::value(bool val)
    {
       subject().value(val);
@@ -167,4 +201,11 @@ namespace cycfi { namespace elements
    {
       subject().value(val);
    }
+
+   bool proxy_base::invalidate(element const* e, int what)
+   {
+      if (subject().invalidate(e, what))
+         return element::invalidate(nullptr, what);
+      return element::invalidate(e, what);
+   }
 }}
@@ -38,18 +38,20 @@ namespace cycfi { namespace elements
       {
          context sctx { ctx, &thumb(), ctx.bounds };
          sctx.bounds = track_bounds(sctx);
+         track().clear_dirty(limits_dirty | layout_dirty);
          track().layout(sctx);
       }
       {
          context sctx { ctx, &track(), ctx.bounds };
          sctx.bounds = thumb_bounds(sctx);
+         thumb().clear_dirty(limits_dirty | layout_dirty);
          thumb().layout(sctx);
       }
    }
 
    void slider_base::draw(context const& ctx)
    {
-      if (intersects(ctx.bounds, ctx.view.dirty()))
+      if (intersects(ctx.bounds, ctx.visible) && ctx.view.is_dirty(ctx.bounds))
       {
          {
             context sctx { ctx, &track(), ctx.bounds };
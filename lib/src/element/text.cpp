@@ -9,6 +9,7 @@
 #include <elements/support/text_utils.hpp>
 #include <elements/support/context.hpp>
 #include <elements/view.hpp>
+#include <algorithm>
 
 namespace cycfi { namespace elements
 {
@@ -23,8 +24,8 @@ namespace cycfi { namespace elements
     , float size
     , color color_
    )
-    : _text(text)
-    , _layout(_text.data(), _text.data() + _text.size(), face, size)
+    : _buffer(std::make_unique<string_buffer>(text))
+    , _layout(_buffer->str().data(), _buffer->str().data() + _buffer->size(), face, size)
     , _color(color_)
    {}
 
@@ -50,15 +51,18 @@ namespace cycfi { namespace elements
    {
       sync();
 
-      _rows.clear();
       auto  new_x = ctx.bounds.width();
-      _layout.break_lines(new_x, _rows);
+      _layout.break_lines(new_x);
       auto  size = _layout.metrics();
-      auto  new_y = _rows.size() * (size.ascent + size.descent + size.leading);
+      auto  new_y = _layout.lines().size() * (size.ascent + size.descent + size.leading);
 
-      // Refresh the whole view if the size has changed
+      // Our limits depend on the size. Invalidate and refresh the whole
+      // view if the size has changed
       if (_current_size.x != new_x || _current_size.y != new_y)
+      {
+         invalidate(ctx, limits_dirty);
          ctx.view.refresh();
+      }
 
       _current_size.x = new_x;
       _current_size.y = new_y;
@@ -76,29 +80,49 @@ namespace cycfi { namespace elements
       cnv.rect(ctx.bounds);
       cnv.clip();
       cnv.fill_style(_color);
-      for (auto& row : _rows)
+
+      // Start with the first visible row
+      double clip_top, clip_bottom, ignore;
+      cairo_clip_extents(&cnv.cairo_context(), &ignore, &clip_top, &ignore, &clip_bottom);
+      auto const& rows = _layout.lines();
+      auto i = std::upper_bound(rows.begin(), rows.end(), float(clip_top) - ctx.bounds.top,
+         [line_height](float y, glyphs const& row) { return y < row.y() + line_height; }
+      );
+
+      auto  bottom = std::min<float>(ctx.bounds.bottom, clip_bottom);
+      for (; i != rows.end(); ++i)
       {
-         row.draw({ x, y }, cnv);
-         y += line_height;
-         if (y > ctx.bounds.bottom + metrics.ascent)
+         auto  row_y = y + i->y();
+         if (row_y > bottom + metrics.ascent)
             break;
+         i->draw({ x, row_y }, cnv);
       }
    }
 
    void static_text_box::sync() const
    {
-      auto f = _text.data();
-      auto l = _text.data() + _text.size();
-      if (f != _layout.begin() || l != _layout.end())
+      auto f = text().data();
+      auto l = f + text().size();
+      if (f != _layout.begin() || l != _layout.end() || _layout.edited())
          _layout.text(f, l);
    }
 
-   void static_text_box::text(std::string_view text)
+   void static_text_box::text(std::string_view text_)
    {
-      replace_string(_text, text);
-      _rows.clear();
-      _layout.text(_text.data(), _text.data() + _text.size());
-      _layout.break_lines(_current_size.x, _rows);
+      _layout.edit(0, _buffer->size(), text_.size());
+      _buffer->assign(text_);
+      _layout.text(text().data(), text().data() + text().size());
+      _layout.break_lines(_current_size.x);
+   }
+
+   void static_text_box::buffer(text_buffer_ptr buffer_)
+   {
+      if (!buffer_)
+         return;
+      buffer_->assign(text());
+      _buffer = std::move(buffer_);
+      _layout.text(text().data(), text().data() + text().size());
+      _layout.break_lines(_current_size.x);
    }
 
    void static_text_box::value(std::string val)
@@ -114,13 +138,44 @@ namespace cycfi { namespace elements
     , _select_start(-1)
     , _select_end(-1)
     , _current_x(0)
+    , _paste_token(std::make_shared<char>())
     , _is_focus(false)
     , _show_caret(true)
     , _caret_started(false)
+    , _scroll_pending(false)
    {}
 
+   basic_text_box::basic_text_box(basic_text_box&& rhs)
+    : static_text_box(std::move(rhs))
+    , _select_start(rhs._select_start)
+    , _select_end(rhs._select_end)
+    , _current_x(rhs._current_x)
+    , _edit(std::move(rhs._edit))
+    , _paste_token(std::make_shared<char>())
+    , _is_focus(rhs._is_focus)
+    , _show_caret(true)
+    , _caret_started(false)
+    , _scroll_pending(rhs._scroll_pending)
+   {
+      // The pending blink and pastes refer to rhs. Stop them; the next
+      // draw restarts the caret for this box.
+      rhs.stop_caret();
+      rhs._paste_token = std::make_shared<char>();
+   }
+
    basic_text_box::~basic_text_box()
-   {}
+   {
+      stop_caret();
+   }
+
+   void basic_text_box::stop_caret()
+   {
+      if (_caret_timer)
+         _caret_view->cancel(_caret_timer);
+      _caret_timer = {};
+      _caret_view = nullptr;
+      _caret_started = false;
+   }
 
    void basic_text_box::draw(context const& ctx)
    {
@@ -129,6 +184,19 @@ namespace cycfi { namespace elements
       draw_caret(ctx);
    }
 
+   void basic_text_box::layout(context const& ctx)
+   {
+      static_text_box::layout(ctx);
+
+      // Text changed outside an event (e.g. an asynchronous paste) is
+      // scrolled into view at the next layout
+      if (_scroll_pending)
+      {
+         _scroll_pending = false;
+         scroll_into_view(ctx, true);
+      }
+   }
+
    element* basic_text_box::click(context const& ctx, mouse_button btn)
    {
       _show_caret = true;
@@ -136,15 +204,15 @@ namespace cycfi { namespace elements
       if (!btn.down) // released? return early
          return this;
 
-      if (_text.empty())
+      if (_buffer->empty())
       {
          _select_start = _select_end = 0;
          scroll_into_view(ctx, false);
          return this;
       }
 
-      char const*   _first = _text.data();
-      char const*   _last = _first + _text.size();
+      char const*   _first = text().data();
+      char const*   _last = _first + _buffer->size();
 
       if (char const* pos = caret_position(ctx, btn.pos))
       {
@@ -190,12 +258,16 @@ namespace cycfi { namespace elements
          _current_x = btn.pos.x-ctx.bounds.left;
          ctx.view.refresh(ctx);
       }
+
+      // Selection drags go straight to us
+      ctx.view.capture_pointer(ctx);
       return this;
    }
 
    void basic_text_box::drag(context const& ctx, mouse_button btn)
    {
-      char const* first = &_text[0];
+      ctx.view.capture_pointer(ctx);
+      char const* first = text().data();
       if (char const* pos = caret_position(ctx, btn.pos))
       {
          _select_end = int(pos-first);
@@ -214,22 +286,73 @@ namespace cycfi { namespace elements
       return false;
    }
 
-   namespace
+   struct basic_text_box::text_edit
+   {
+      bool              empty() const { return removed.empty() && inserted.empty(); }
+      bool              follows(int p) const { return p == pos + int(inserted.size()); }
+      void              record(text_buffer const& buf, int p, int n, std::string_view text);
+
+      void selected_after(int start, int end)
+      {
+         select_start_after = start;
+         select_end_after = end;
+      }
+
+      int               pos = 0;          // Where the edit starts
+      std::string       removed;          // The original text
+      std::string       inserted;         // What replaced it
+      int               select_start_before;
+      int               select_end_before;
+      int               select_start_after;
+      int               select_end_after;
+   };
+
+   // Merges the replacement of n bytes at p (in the current text) into the
+   // edit. Only the bytes touched are copied.
+   void basic_text_box::text_edit::record(
+      text_buffer const& buf, int p, int n, std::string_view text)
    {
-      void add_undo(
-         context const& ctx
-       , std::function<void()>& typing_state
-       , std::function<void()> undo_f
-       , std::function<void()> redo_f
-      )
+      int a = pos;
+      int b = pos + int(inserted.size());
+      int q = p + n;
+
+      if (empty())
+      {
+         pos = p;
+         removed = buf.substr(p, n);
+         inserted = text;
+      }
+      else if (p >= a && q <= b)
       {
-         if (typing_state)
+         inserted.replace(p - a, n, text);
+      }
+      else
+      {
+         // The current text in [first, last). Outside [a, b), the current
+         // text is still the original text.
+         auto current = [&](int first, int last)
          {
-            ctx.view.add_undo({ typing_state, undo_f });
-            typing_state = {}; // reset
-         }
-         ctx.view.add_undo({ undo_f, redo_f });
-      };
+            std::string r;
+            if (first < a)
+               r += buf.substr(first, std::min(last, a) - first);
+            int from = std::max(first, a);
+            int to = std::min(last, b);
+            if (from < to)
+               r.append(inserted, from - a, to - from);
+            if (last > b)
+            {
+               from = std::max(first, b);
+               r += buf.substr(from, last - from);
+            }
+            return r;
+         };
+
+         int first = std::min(p, a);
+         int last = std::max(q, b);
+         removed = current(first, a) + removed + current(b, last);
+         inserted = current(first, p) + std::string{ text } + current(q, last);
+         pos = first;
+      }
    }
 
    bool basic_text_box::text(context const& ctx, text_info info_)
@@ -239,18 +362,26 @@ namespace cycfi { namespace elements
       if (_select_start == -1)
          return false;
 
-      std::string text = codepoint_to_utf8(info_.codepoint);
+      // Repeated entries of the same codepoint are inserted in one go
+      std::string text;
+      auto utf8 = codepoint_to_utf8(info_.codepoint);
+      for (int i = 0; i < std::max(info_.count, 1); ++i)
+         text += utf8;
 
-      if (!_typing_state)
-         _typing_state = capture_state();
+      int start = std::min(_select_end, _select_start);
+      int end = std::max(_select_end, _select_start);
 
-      if (_select_start == _select_end)
-         _text.insert(_select_start, text);
-      else
-         _text.replace(_select_start, _select_end-_select_start, text);
-      _select_end = ++_select_start;
+      // Typing continues the current undo step while the caret stays at
+      // the end of the text typed so far
+      if (!_edit || start != end || !_edit->follows(start))
+         begin_edit(ctx.view);
 
-      _layout.text(_text.data(), _text.data() + _text.size());
+      replace(start, end-start, text);
+      _select_start = start + int(text.size());
+      _select_end = _select_start;
+      _edit->selected_after(_select_start, _select_end);
+
+      _layout.text(this->text().data(), this->text().data() + this->text().size());
       layout(ctx);
 
       scroll_into_view(ctx, true);
@@ -259,6 +390,8 @@ namespace cycfi { namespace elements
 
    void basic_text_box::text(std::string_view text_)
    {
+      // Text set programmatically is not journaled
+      _edit.reset();
       static_text_box::text(text_);
       _select_start = std::min<int>(_select_start, text_.size());
       _select_end = std::min<int>(_select_end, text_.size());
@@ -280,57 +413,53 @@ namespace cycfi { namespace elements
 
       int start = std::min(_select_end, _select_start);
       int end = std::max(_select_end, _select_start);
-      std::function<void()> undo_f = capture_state();
+
+      // Folded key repeats are applied at once to deletion and caret
+      // movement
+      int const count = k.action == key_action::repeat ? std::max(k.count, 1) : 1;
 
       auto up_down = [this, &ctx, k, &move_caret]()
       {
          bool up = k.key == key_code::up;
          glyph_metrics info;
-         info = glyph_info(ctx, &_text[_select_end]);
+         info = glyph_info(ctx, text().data() + _select_end);
          if (info.str)
          {
             auto y = up ? -info.line_height : +info.line_height;
             auto pos = point{ ctx.bounds.left + _current_x, info.pos.y + y };
             char const* cp = caret_position(ctx, pos);
             if (cp)
-               _select_end = int(cp - &_text[0]);
+               _select_end = int(cp - text().data());
             else
-               _select_end = up ? 0 : int(_text.size());
+               _select_end = up ? 0 : int(_buffer->size());
             move_caret = true;
          }
       };
 
       auto next_char = [this]()
       {
-         if (_select_end < _text.size())
-         {
-            char const* end = _text.data() + _text.size();
-            char const* p = next_utf8(end, &_text[_select_end]);
-            _select_end = int(p - &_text[0]);
-         }
+         if (_select_end < int(_buffer->size()))
+            _select_end = int(_buffer->next_char(_select_end));
       };
 
       auto prev_char = [this]()
       {
          if (_select_end > 0)
-         {
-            char const* start = &_text[0];
-            char const* p = prev_utf8(start, &_text[_select_end]);
-            _select_end = int(p - &_text[0]);
-         }
+            _select_end = int(_buffer->prev_char(_select_end));
       };
 
       auto next_word = [this]()
       {
-         if (_select_end < _text.size())
+         if (_select_end < int(_buffer->size()))
          {
-            char const* p = &_text[_select_end];
-            char const* end = _text.data() + _text.size();
+            char const* start = text().data();
+            char const* p = start + _select_end;
+            char const* end = start + text().size();
             while (p != end && word_break(p))
                p = next_utf8(end, p);
             while (p != end && !word_break(p))
                p = next_utf8(end, p);
-            _select_end = int(p - &_text[0]);
+            _select_end = int(p - start);
          }
       };
 
@@ -338,15 +467,15 @@ namespace cycfi { namespace elements
       {
          if (_select_end > 0)
          {
-            char const* start = &_text[0];
-            char const* p = prev_utf8(start, &_text[_select_end]);
+            char const* start = text().data();
+            char const* p = prev_utf8(start, start + _select_end);
             while (p != start && word_break(p))
                p = prev_utf8(start, p);
             while (p != start && !word_break(p))
                p = prev_utf8(start, p);
-            char const* end = _text.data() + _text.size();
+            char const* end = start + text().size();
             p = next_utf8(end, p);
-            _select_end = int(p - &_text[0]);
+            _select_end = int(p - start);
          }
       };
 
@@ -356,11 +485,12 @@ namespace cycfi { namespace elements
          {
             case key_code::enter:
                {
-                  _text.replace(start, end-start, "\n");
-                  _select_start += 1;
+                  begin_edit(ctx.view);
+                  replace(start, end-start, "\n");
+                  _select_start = start + 1;
                   _select_end = _select_start;
+                  end_edit(ctx.view);
                   save_x = true;
-                  add_undo(ctx, _typing_state, undo_f, capture_state());
                   handled = true;
                }
                break;
@@ -368,9 +498,11 @@ namespace cycfi { namespace elements
             case key_code::backspace:
             case key_code::_delete:
                {
-                  delete_();
+                  begin_edit(ctx.view);
+                  for (int i = 0; i != count; ++i)
+                     delete_();
+                  end_edit(ctx.view);
                   save_x = true;
-                  add_undo(ctx, _typing_state, undo_f, capture_state());
                   handled = true;
                }
                break;
@@ -378,10 +510,13 @@ namespace cycfi { namespace elements
             case key_code::left:
                if (_select_end != -1)
                {
-                  if (k.modifiers & mod_alt)
-                     prev_word();
-                  else
-                     prev_char();
+                  for (int i = 0; i != count; ++i)
+                  {
+                     if (k.modifiers & mod_alt)
+                        prev_word();
+                     else
+                        prev_char();
+                  }
                   if (!(k.modifiers & mod_shift))
                      _select_start = _select_end = std::min(_select_start, _select_end);
                }
@@ -393,10 +528,13 @@ namespace cycfi { namespace elements
             case key_code::right:
                if (_select_end != -1)
                {
-                  if (k.modifiers & mod_alt)
-                     next_word();
-                  else
-                     next_char();
+                  for (int i = 0; i != count; ++i)
+                  {
+                     if (k.modifiers & mod_alt)
+                        next_word();
+                     else
+                        next_char();
+                  }
                   if (!(k.modifiers & mod_shift))
                      _select_start = _select_end = std::max(_select_start, _select_end);
                }
@@ -408,7 +546,10 @@ namespace cycfi { namespace elements
             case key_code::up:
             case key_code::down:
                if (_select_start != -1)
-                  up_down();
+               {
+                  for (int i = 0; i != count; ++i)
+                     up_down();
+               }
                handled = true;
                break;
 
@@ -416,7 +557,7 @@ namespace cycfi { namespace elements
                if (k.modifiers & mod_action)
                {
                   _select_start = 0;
-                  _select_end = int(_text.size());
+                  _select_end = int(_buffer->size());
                   handled = true;
                }
                break;
@@ -424,9 +565,10 @@ namespace cycfi { namespace elements
             case key_code::x:
                if (k.modifiers & mod_action)
                {
+                  begin_edit(ctx.view);
                   cut(ctx.view, start, end);
+                  end_edit(ctx.view);
                   save_x = true;
-                  add_undo(ctx, _typing_state, undo_f, capture_state());
                   handled = true;
                }
                break;
@@ -442,22 +584,17 @@ namespace cycfi { namespace elements
             case key_code::v:
                if (k.modifiers & mod_action)
                {
+                  // The text is inserted later, when the clipboard is read
+                  // (see pasted)
                   paste(ctx.view, start, end);
-                  save_x = true;
-                  add_undo(ctx, _typing_state, undo_f, capture_state());
-                  handled = true;
+                  return true;
                }
                break;
 
             case key_code::z:
                if (k.modifiers & mod_action)
                {
-                  if (_typing_state)
-                  {
-                     ctx.view.add_undo({ _typing_state, undo_f });
-                     _typing_state = {}; // reset
-                  }
-
+                  commit_edit(ctx.view);
                   if (k.modifiers & mod_shift)
                      ctx.view.redo();
                   else
@@ -473,14 +610,14 @@ namespace cycfi { namespace elements
 
       if (move_caret)
       {
-         clamp(_select_start, 0, int(_text.size()));
-         clamp(_select_end, 0, int(_text.size()));
+         clamp(_select_start, 0, int(_buffer->size()));
+         clamp(_select_end, 0, int(_buffer->size()));
          if (!(k.modifiers & mod_shift))
             _select_start = _select_end;
       }
       else if (handled)
       {
-         _layout.text(_text.data(), _text.data() + _text.size());
+         _layout.text(text().data(), text().data() + text().size());
          layout(ctx);
          ctx.view.refresh(ctx);
       }
@@ -506,7 +643,7 @@ namespace cycfi { namespace elements
       bool has_caret = false;
 
       // Handle the case where text is empty
-      if (_is_focus && _text.empty())
+      if (_is_focus && _buffer->empty())
       {
          auto  size = _layout.metrics();
          auto  line_height = size.ascent + size.descent + size.leading;
@@ -529,7 +666,7 @@ namespace cycfi { namespace elements
       // Draw the caret
       else if (_is_focus && (_select_start != -1) && (_select_start == _select_end))
       {
-         auto  start_info = glyph_info(ctx, _text.data() + _select_start);
+         auto  start_info = glyph_info(ctx, text().data() + _select_start);
          auto width = theme.text_box_caret_width;
          rect& caret = start_info.bounds;
 
@@ -549,12 +686,17 @@ namespace cycfi { namespace elements
       if (_is_focus && has_caret && !_caret_started)
       {
          _caret_started = true;
-         ctx.view.post(500ms,
-                       [this, &_view = ctx.view, caret_bounds]() {
-                          _show_caret = !_show_caret;
-                          _view.refresh(caret_bounds);
-                          _caret_started = false;
-                       }
+         _caret_view = &ctx.view;
+         _caret_timer = ctx.view.post(500ms,
+            [this, caret_bounds]()
+            {
+               auto& view_ = *_caret_view;
+               _caret_timer = {};
+               _caret_view = nullptr;
+               _caret_started = false;
+               _show_caret = !_show_caret;
+               view_.refresh(caret_bounds);
+            }
          );
       }
    }
@@ -567,13 +709,13 @@ namespace cycfi { namespace elements
       auto& canvas = ctx.canvas;
       auto const& theme = get_theme();
 
-      if (!_text.empty())
+      if (!_buffer->empty())
       {
-         auto  start_info = glyph_info(ctx, _text.data() + _select_start);
+         auto  start_info = glyph_info(ctx, text().data() + _select_start);
          rect& r1 = start_info.bounds;
          r1.right = ctx.bounds.right;
 
-         auto  end_info = glyph_info(ctx, _text.data() + _select_end);
+         auto  end_info = glyph_info(ctx, text().data() + _select_end);
          rect& r2 = end_info.bounds;
          r2.right = r2.left;
          r2.left = ctx.bounds.left;
@@ -606,50 +748,35 @@ namespace cycfi { namespace elements
    char const* basic_text_box::caret_position(context const& ctx, point p)
    {
       auto  x = ctx.bounds.left;
-      auto  y = ctx.bounds.top;
+      auto  y = p.y - ctx.bounds.top;
       auto  metrics = _layout.metrics();
       auto  line_height = metrics.ascent + metrics.descent + metrics.leading;
+      auto const& rows = _layout.lines();
 
-      char const* found = nullptr;
-      for (auto& row : _rows)
-      {
-         // Check if p is within this row
-         if ((p.y >= y) && (p.y < y + line_height))
-         {
-            // Check if we are at the very start of the row or beyond
-            if (p.x <= x)
-            {
-               found = row.begin();
-               break;
-            }
+      if (rows.empty() || y < 0)
+         return nullptr;
 
-            // Get the actual coordinates of the glyph
-            row.for_each(
-               [p, x, &found](char const* utf8, float left, float right)
-               {
-                  if ((p.x >= (x + left)) && (p.x < (x + right)))
-                  {
-                     found = utf8;
-                     return false;
-                  }
-                  return true;
-               }
-            );
-            // Assume it's at the end of the row if we haven't found a hit
-            if (!found)
-               found = row.end();
-            break;
-         }
-         y += line_height;
-      }
-      return found;
+      // Find the row at p.y
+      auto i = std::upper_bound(rows.begin(), rows.end(), y,
+         [](float y, glyphs const& row) { return y < row.y(); }
+      );
+      auto const& row = *(i - 1);
+      if (y >= row.y() + line_height)
+         return nullptr;
+
+      // Check if we are at the very start of the row or beyond
+      if (p.x <= x)
+         return row.begin();
+
+      // The glyph at p.x, or the end of the row if we haven't found a hit
+      return row.hit(p.x - x);
    }
 
    basic_text_box::glyph_metrics basic_text_box::glyph_info(context const& ctx, char const* s)
    {
       auto  metrics = _layout.metrics();
       auto  x = ctx.bounds.left;
-      auto  y = ctx.bounds.top + metrics.ascent;
+      auto  top = ctx.bounds.top + metrics.ascent;
       auto  descent = metrics.descent;
       auto  ascent = metrics.ascent;
       auto  leading = metrics.leading;
@@ -659,56 +786,43 @@ namespace cycfi { namespace elements
       info.str = nullptr;
       info.line_height = line_height;
 
-      // Check if s is at the very end
-      if (s == _text.data() + _text.size())
-      {
-         auto const& last_row = _rows.back();
-         auto        rightmost = x + last_row.width();
-         auto        bottom_y = y + (line_height * (_rows.size() - 1));
-
-         info.pos = { rightmost, bottom_y };
-         info.bounds = { rightmost, bottom_y - ascent, rightmost + 10, bottom_y + descent };
-         info.str = s;
+      auto const& rows = _layout.lines();
+      if (rows.empty())
          return info;
-      }
 
-      glyphs*  prev_row = nullptr;
-      for (auto& row : _rows)
+      auto at_end_of = [&](glyphs const& row)
       {
-         // Check if s is within this row
-         if (s >= row.begin() && s < row.end())
-         {
-            // Get the actual coordinates of the glyph
-            row.for_each(
-               [s, &info, x, y, ascent, descent](char const* utf8, float left, float right)
-               {
-                  if (utf8 >= s)
-                  {
-                     info.pos = { x + left, y };
-                     info.bounds = { x + left, y - ascent, x + right, y + descent };
-                     info.str = utf8;
-                     return false;
-                  }
-                  return true;
-               }
-            );
-            break;
-         }
-         // This handles the case where s is in between the start of the
-         // current row and the end of the previous.
-         else if (s < row.begin() && prev_row)
-         {
-            auto  rightmost = x + prev_row->width();
-            auto  prev_y = y - line_height;
-            info.pos = { rightmost, prev_y };
-            info.bounds = { rightmost, prev_y - ascent, rightmost + 10, prev_y + descent };
-            info.str = s;
-            break;
-         }
-         y += line_height;
-         prev_row = &row;
-      }
+         auto  rightmost = x + row.width();
+         auto  y = top + row.y();
+         info.pos = { rightmost, y };
+         info.bounds = { rightmost, y - ascent, rightmost + 10, y + descent };
+         info.str = s;
+         return info;
+      };
 
+      // Check if s is at the very end
+      if (s == text().data() + _buffer->size())
+         return at_end_of(rows.back());
+
+      // Find the last row that starts at or before s
+      auto i = std::upper_bound(rows.begin(), rows.end(), s,
+         [](char const* s, glyphs const& row) { return s < row.begin(); }
+      );
+      if (i == rows.begin())
+         return info;
+      auto const& row = *(i - 1);
+
+      // This handles the case where s is in between the end of the row
+      // and the start of the next.
+      if (s >= row.end())
+         return at_end_of(row);
+
+      // Get the actual coordinates of the glyph
+      auto  glyph = row.position(s);
+      auto  y = top + row.y();
+      info.pos = { x + glyph.left, y };
+      info.bounds = { x + glyph.left, y - ascent, x + glyph.right, y + descent };
+      info.str = glyph.str;
       return info;
    }
 
@@ -722,16 +836,14 @@ namespace cycfi { namespace elements
          {
             if (start > 0)
             {
-               char const* start_p = &_text[0];
-               char const* end_p = &_text[start];
-               char const* p = prev_utf8(start_p, end_p);
-               start = int(p - &_text[0]);
-               _text.erase(start, end_p - p);
+               auto prev = int(_buffer->prev_char(start));
+               replace(prev, start - prev, "");
+               start = prev;
             }
          }
          else
          {
-            _text.erase(start, end-start);
+            replace(start, end-start, "");
          }
          _select_end = _select_start = start;
       }
@@ -743,7 +855,7 @@ namespace cycfi { namespace elements
       {
          auto  end_ = std::max(start, end);
          auto  start_ = std::min(start, end);
-         clipboard(_text.substr(start, end_-start_));
+         clipboard(_buffer->substr(start, end_-start_));
          delete_();
       }
    }
@@ -754,7 +866,7 @@ namespace cycfi { namespace elements
       {
          auto  end_ = std::max(start, end);
          auto  start_ = std::min(start, end);
-         clipboard(_text.substr(start, end_-start_));
+         clipboard(_buffer->substr(start, end_-start_));
       }
    }
 
@@ -764,49 +876,105 @@ namespace cycfi { namespace elements
       {
          auto  end_ = std::max(start, end);
          auto  start_ = std::min(start, end);
-         std::string ins = clipboard();
-         _text.replace(start, end_-start_, ins);
-         start += ins.size();
-         _select_end = _select_start = start;
+
+         // The clipboard is read asynchronously. Its text is delivered in
+         // chunks, one per frame, each inserted after the previous one.
+         v.paste_clipboard(paste_token(),
+            [this, &v, start_, end_, pos = -1](std::string_view chunk, bool last) mutable
+            {
+               // The text may have changed while waiting for the clipboard
+               if (pos == -1)
+               {
+                  auto size = int(_buffer->size());
+                  auto first = std::min(start_, size);
+                  begin_edit(v);
+                  replace(first, std::min(end_, size) - first, "");
+                  pos = first;
+               }
+               replace(pos, 0, chunk);
+               pos += int(chunk.size());
+
+               if (last)
+               {
+                  _select_end = _select_start = pos;
+                  pasted(v);
+               }
+            }
+         );
       }
    }
 
-   struct basic_text_box::state_saver
+   void basic_text_box::pasted(view& v)
    {
-      state_saver(basic_text_box* this_)
-       : text(this_->_text)
-       , select_start(this_->_select_start)
-       , select_end(this_->_select_end)
-       , save_text(this_->_text)
-       , save_select_start(this_->_select_start)
-       , save_select_end(this_->_select_end)
-      {}
+      end_edit(v);
 
-      void operator()()
+      _layout.text(text().data(), text().data() + text().size());
+      _scroll_pending = true;
+      v.layout(*this);
+      v.refresh(*this);
+   }
+
+   void basic_text_box::begin_edit(view& v)
+   {
+      commit_edit(v);
+      _edit = std::make_shared<text_edit>();
+      _edit->select_start_before = _select_start;
+      _edit->select_end_before = _select_end;
+      _edit->selected_after(_select_start, _select_end);
+   }
+
+   void basic_text_box::end_edit(view& v)
+   {
+      if (_edit)
+         _edit->selected_after(_select_start, _select_end);
+      commit_edit(v);
+   }
+
+   void basic_text_box::commit_edit(view& v)
+   {
+      auto edit = std::move(_edit);
+      if (!edit || edit->empty())
+         return;
+
+      auto  self = weak_from_this();
+      bool  shared = !self.expired();
+      auto  restore = [this, self, shared, edit](bool undo)
       {
-         text = save_text;
-         select_start = save_select_start;
-         select_end = save_select_end;
-      }
+         if (shared && self.expired())
+            return;
 
-      std::string&   text;
-      int&           select_start;
-      int&           select_end;
+         auto const& from = undo? edit->inserted : edit->removed;
+         auto const& to = undo? edit->removed : edit->inserted;
+         if (edit->pos + from.size() > _buffer->size())
+            return;
 
-      std::string    save_text;
-      int            save_select_start;
-      int            save_select_end;
-   };
+         _edit.reset();
+         _buffer->replace(edit->pos, from.size(), to);
+         _layout.edit(edit->pos, from.size(), to.size());
+         _select_start = undo? edit->select_start_before : edit->select_start_after;
+         _select_end = undo? edit->select_end_before : edit->select_end_after;
+         clamp(_select_start, -1, int(_buffer->size()));
+         clamp(_select_end, -1, int(_buffer->size()));
+      };
 
-   std::function<void()>
-   basic_text_box::capture_state()
+      v.add_undo({
+         [restore]() { restore(true); }
+       , [restore]() { restore(false); }
+       , sizeof(text_edit) + edit->removed.size() + edit->inserted.size()
+      });
+   }
+
+   void basic_text_box::replace(int pos, int n, std::string_view text)
    {
-      return state_saver(this);
+      if (_edit)
+         _edit->record(*_buffer, pos, n, text);
+      _buffer->replace(pos, n, text);
+      _layout.edit(pos, n, text.size());
    }
 
    void basic_text_box::scroll_into_view(context const& ctx, bool save_x)
    {
-      if (_text.empty())
+      if (_buffer->empty())
       {
          ctx.view.refresh(ctx);
          return;
@@ -815,7 +983,7 @@ namespace cycfi { namespace elements
       if (_select_end == -1)
          return;
 
-      auto info = glyph_info(ctx, &_text[_select_end]);
+      auto info = glyph_info(ctx, text().data() + _select_end);
       if (info.str)
       {
          auto caret = rect{
@@ -847,6 +1015,7 @@ namespace cycfi { namespace elements
 
          case focus_request::end_focus:
             _is_focus = false;
+            stop_caret();
             return true;
       }
       return false;
@@ -854,20 +1023,20 @@ namespace cycfi { namespace elements
 
    void basic_text_box::select_start(int pos)
    {
-      if (pos == -1 || (pos >= 0 && pos <= _text.size()))
+      if (pos == -1 || (pos >= 0 && pos <= _buffer->size()))
          _select_start = pos;
    }
 
    void basic_text_box::select_end(int pos)
    {
-      if (pos == -1 || (pos >= 0 && pos <= _text.size()))
+      if (pos == -1 || (pos >= 0 && pos <= _buffer->size()))
          _select_end = pos;
    }
 
    void basic_text_box::select_all()
    {
       _select_start = 0;
-      _select_end = int(_text.size());
+      _select_end = int(_buffer->size());
    }
 
    void basic_text_box::select_none()
@@ -928,7 +1097,18 @@ namespace cycfi { namespace elements
    {
       bool r = basic_text_box::text(ctx, info);
       if (on_text)
-         text(on_text(text()));
+      {
+         // The filtered text is part of the typing's undo step
+         auto new_text = on_text(text());
+         if (new_text != text())
+         {
+            replace(0, int(text().size()), new_text);
+            select_start(std::min<int>(select_start(), new_text.size()));
+            select_end(std::min<int>(select_end(), new_text.size()));
+            _layout.text(text().data(), text().data() + text().size());
+            layout(ctx);
+         }
+      }
       return r;
    }
 
@@ -960,7 +1140,7 @@ namespace cycfi { namespace elements
 
             case key_code::end:
                {
-                  int end = int(_text.size());
+                  int end = int(_buffer->size());
                   select_start(end);
                   select_end(end);
                   scroll_into_view(ctx, false);
@@ -981,38 +1161,46 @@ namespace cycfi { namespace elements
          auto  end_ = std::max(start, end);
          auto  start_ = std::min(start, end);
 
-         std::string clip = clipboard();
-         if (clip.empty())
-            return;
-
-         std::string ins;
-
-         // Copy clip ito ins, stop when a newline is found.
-         // Also, limit ins to 256 characters.
-         char const* p = &clip[0];
-         char const* last = p + clip.size();
+         // Copy the clipboard chunks into ins, stop when a newline is
+         // found. Also, limit ins to 256 characters.
+         v.paste_clipboard(paste_token(),
+            [this, &v, start_, end_
+            , ins = std::string{}, full = false](std::string_view chunk, bool last) mutable
+            {
+               for (auto c : chunk)
+               {
+                  if (full || ins.size() == 256 || is_newline(uint8_t(c)))
+                  {
+                     full = true;
+                     break;
+                  }
+                  ins += c;
+               }
 
-         for (int i = 0; (i < 256) && (p != last); ++p, ++i)
-         {
-            if (is_newline(uint8_t(*p)))
-               break;
-            ins += *p;
-         }
+               if (!last || ins.empty())
+                  return;
 
-         _text.replace(start_, end_-start_, ins);
-         start_ += ins.size();
-         select_start(start_);
-         select_end(start_);
+               // The text may have changed while waiting for the clipboard
+               auto size = int(_buffer->size());
+               auto first = std::min(start_, size);
+               begin_edit(v);
+               replace(first, std::min(end_, size) - first, ins);
+               first += ins.size();
+               select_start(first);
+               select_end(first);
 
-         if (on_text)
-         {
-            auto new_text = on_text(_text);
-            if (new_text != _text)
-            {
-               text(new_text);
-               select_all();
+               if (on_text)
+               {
+                  auto new_text = on_text(text());
+                  if (new_text != text())
+                  {
+                     replace(0, int(text().size()), new_text);
+                     select_all();
+                  }
+               }
+               pasted(v);
             }
-         }
+         );
       }
    }
 }}
@@ -5,6 +5,7 @@
 =============================================================================*/
 #include <elements/element/tile.hpp>
 #include <elements/support/context.hpp>
+#include <algorithm>
 
 namespace cycfi { namespace elements
 {
@@ -14,6 +15,24 @@ namespace cycfi { namespace elements
       {
          float min, max, stretch, alloc;
       };
+
+      // Given the sorted tile offsets, find the range of tiles that
+      // overlap [lo, hi] using a binary search.
+      composite_base::index_range
+      tiles_range(std::vector<float> const& tiles, std::size_t size, float lo, float hi)
+      {
+         // Not laid out yet: all the elements are candidates
+         if (tiles.size() != size+1)
+            return { 0, size };
+
+         // first: the first tile that ends at or after lo
+         // last: one past the last tile that starts at or before hi
+         auto first = std::lower_bound(tiles.begin()+1, tiles.end(), lo) - (tiles.begin()+1);
+         auto last = std::upper_bound(tiles.begin(), tiles.end()-1, hi) - tiles.begin();
+         if (last < first)
+            last = first;
+         return { std::size_t(first), std::size_t(last) };
+      }
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -74,6 +93,14 @@ namespace cycfi { namespace elements
 
    void vtile_element::layout(context const& ctx)
    {
+      // We layout all the elements if our horizontal extent or the number
+      // of elements changed. Otherwise, only the elements that moved or
+      // those that were invalidated are laid out (see below).
+      bool relayout =
+         _left != ctx.bounds.left || _right != ctx.bounds.right ||
+         _tiles.size() != size()+1
+         ;
+
       _left = ctx.bounds.left;
       _right = ctx.bounds.right;
       _tiles.resize(size()+1);
@@ -103,19 +130,21 @@ namespace cycfi { namespace elements
       // Now we have the final layout. We can now layout the individual
       // elements.
       double curr = ctx.bounds.top;
-      auto iter = _tiles.begin();
       std::size_t i = 0;
       for (auto const& info : info)
       {
-         *iter++ = curr;
          auto prev = curr;
          curr += info.alloc;
 
-         auto& elem = at(i++);
-         rect ebounds = { _left, float(prev), _right, float(curr) };
-         elem.layout(context{ ctx, &elem, ebounds });
+         auto& elem = at(i);
+         bool moved = _tiles[i] != float(prev) || _tiles[i+1] != float(curr);
+         _tiles[i] = prev;
+
+         if (relayout || moved || (elem.dirty() & layout_dirty))
+            layout_element(ctx, i, { _left, float(prev), _right, float(curr) });
+         ++i;
       }
-      *iter = curr;
+      _tiles[i] = curr;
    }
 
    rect vtile_element::bounds_of(context const& ctx, std::size_t index) const
@@ -125,6 +154,12 @@ namespace cycfi { namespace elements
       return rect{ _left, _tiles[index], _right, _tiles[index+1] };
    }
 
+   vtile_element::index_range
+   vtile_element::range_of(context const& ctx, rect area) const
+   {
+      return tiles_range(_tiles, size(), area.top, area.bottom);
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // Horizontal Tiles
    ////////////////////////////////////////////////////////////////////////////
@@ -148,6 +183,14 @@ namespace cycfi { namespace elements
 
    void htile_element::layout(context const& ctx)
    {
+      // We layout all the elements if our vertical extent or the number
+      // of elements changed. Otherwise, only the elements that moved or
+      // those that were invalidated are laid out (see below).
+      bool relayout =
+         _top != ctx.bounds.top || _bottom != ctx.bounds.bottom ||
+         _tiles.size() != size()+1
+         ;
+
       _top = ctx.bounds.top;
       _bottom = ctx.bounds.bottom;
       _tiles.resize(size()+1);
@@ -177,19 +220,21 @@ namespace cycfi { namespace elements
       // Now we have the final layout. We can now layout the individual
       // elements.
       double curr = ctx.bounds.left;
-      auto iter = _tiles.begin();
       std::size_t i = 0;
       for (auto const& info : info)
       {
-         *iter++ = curr;
          auto prev = curr;
          curr += info.alloc;
 
-         auto& elem = at(i++);
-         rect ebounds = { float(prev), _top, float(curr), _bottom };
-         elem.layout(context{ ctx, &elem, ebounds });
+         auto& elem = at(i);
+         bool moved = _tiles[i] != float(prev) || _tiles[i+1] != float(curr);
+         _tiles[i] = prev;
+
+         if (relayout || moved || (elem.dirty() & layout_dirty))
+            layout_element(ctx, i, { float(prev), _top, float(curr), _bottom });
+         ++i;
       }
-      *iter = curr;
+      _tiles[i] = curr;
    }
 
    rect htile_element::bounds_of(context const& ctx, std::size_t index) const
@@ -198,4 +243,10 @@ namespace cycfi { namespace elements
          return {};
       return rect{ _tiles[index], _top, _tiles[index + 1], _bottom };
    }
+
+   htile_element::index_range
+   htile_element::range_of(context const& ctx, rect area) const
+   {
+      return tiles_range(_tiles, size(), area.left, area.right);
+   }
 }}
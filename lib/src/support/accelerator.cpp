@@ -0,0 +1,42 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/accelerator.hpp>
+#include <algorithm>
+
+namespace cycfi { namespace elements
+{
+   accelerator_table::accelerator_id
+   accelerator_table::add(shortcut_key k, function f, element const* scope)
+   {
+      auto id = _next_id++;
+      _map[k].push_back({ id, scope, std::move(f) });
+      _ids[id] = k;
+      return id;
+   }
+
+   bool accelerator_table::remove(accelerator_id id)
+   {
+      auto i = _ids.find(id);
+      if (i == _ids.end())
+         return false;
+
+      auto j = _map.find(i->second);
+      if (j != _map.end())
+      {
+         auto& list = j->second;
+         list.erase(
+            std::remove_if(list.begin(), list.end(),
+               [id](entry const& e) { return e.id == id; }
+            ),
+            list.end()
+         );
+         if (list.empty())
+            _map.erase(j);
+      }
+      _ids.erase(i);
+      return true;
+   }
+}}
@@ -0,0 +1,137 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/animation.hpp>
+#include <elements/element/element.hpp>
+#include <algorithm>
+
+namespace cycfi { namespace elements
+{
+   namespace easing
+   {
+      double linear(double t)
+      {
+         return t;
+      }
+
+      double ease_in(double t)
+      {
+         return t * t * t;
+      }
+
+      double ease_out(double t)
+      {
+         t = 1 - t;
+         return 1 - (t * t * t);
+      }
+
+      double ease_in_out(double t)
+      {
+         return (t < 0.5)? 4 * t * t * t : ease_out(2 * t - 1) / 2 + 0.5;
+      }
+   }
+
+   animator::animation_id animator::add(
+      element* target
+    , duration d
+    , update_function update
+    , easing::function ease
+    , int property
+    , done_function done
+   )
+   {
+      if (property != no_property)
+      {
+         auto i = std::find_if(_animations.begin(), _animations.end(),
+            [target, property](animation const& a)
+            {
+               return a.update && a.target == target && a.property == property;
+            }
+         );
+         if (i != _animations.end())
+            i->update = nullptr; // removed in the next tick
+      }
+
+      std::weak_ptr<element> owner;
+      if (target)
+         owner = target->weak_from_this();
+      bool has_owner = !owner.expired();
+
+      auto id = _next_id++;
+      _animations.push_back(
+         { id, target, owner, has_owner, property, {}, false, d, ease
+         , std::move(update), std::move(done) }
+      );
+      return id;
+   }
+
+   bool animator::cancel(animation_id id)
+   {
+      for (auto& a : _animations)
+      {
+         if (a.id == id && a.update)
+         {
+            a.update = nullptr;
+            return true;
+         }
+      }
+      return false;
+   }
+
+   void animator::tick(time_point now, element_list& updated)
+   {
+      // Animations added by the callbacks are updated starting with the
+      // next tick.
+      auto size = _animations.size();
+      for (std::size_t i = 0; i != size; ++i)
+      {
+         if (!_animations[i].update)
+            continue;
+
+         auto& a = _animations[i];
+
+         // Drop the animation if its target is gone
+         if (a.has_owner && a.owner.expired())
+         {
+            a.update = nullptr;
+            a.done = nullptr;
+            continue;
+         }
+
+         if (!a.started)
+         {
+            a.start = now;
+            a.started = true;
+         }
+
+         double t = 1;
+         if (a.length.count() > 0)
+            t = std::min(1.0, std::chrono::duration<double>(now - a.start) / a.length);
+
+         // Copy the callbacks first, the update may add animations
+         auto update = a.update;
+         auto target = a.target;
+         bool finished = t >= 1;
+         update(a.ease(t));
+         if (target)
+            updated.push_back(target);
+
+         if (finished && _animations[i].update)
+         {
+            auto done = std::move(_animations[i].done);
+            _animations[i].update = nullptr;
+            if (done)
+               done();
+         }
+      }
+
+      _animations.erase(
+         std::remove_if(_animations.begin(), _animations.end(),
+            [](animation const& a) { return !a.update; }
+         ),
+         _animations.end()
+      );
+   }
+}}
@@ -5,11 +5,17 @@
 =============================================================================*/
 #include <elements/support/glyphs.hpp>
 #include <elements/support/detail/scratch_context.hpp>
+#include <algorithm>
 
 namespace cycfi { namespace elements
 {
    static detail::scratch_context scratch_context_;
 
+   namespace
+   {
+      constexpr std::size_t max_spare_paragraphs = 4;
+   }
+
    glyphs::glyphs(char const* first, char const* last)
     : _first(first)
     , _last(last)
@@ -20,25 +26,33 @@ namespace cycfi { namespace elements
 
    glyphs::glyphs(
       char const* first, char const* last
-    , int glyph_start, int glyph_end
-    , int cluster_start, int cluster_end
+    , cairo_glyph_t const* glyphs_, int glyph_count
+    , cairo_text_cluster_t const* clusters_, int cluster_count
+    , float const* advances
+    , float const* cluster_x, int const* cluster_bytes
     , master_glyphs const& master
     , bool strip_leading_spaces
+    , float y
    )
     : _first(first)
     , _last(last)
     , _scaled_font(master._scaled_font)
-    , _glyphs(master._glyphs + glyph_start)
-    , _glyph_count(glyph_end - glyph_start)
-    , _clusters(master._clusters + cluster_start)
-    , _cluster_count(cluster_end - cluster_start)
+    , _glyphs(glyphs_)
+    , _glyph_count(glyph_count)
+    , _clusters(clusters_)
+    , _cluster_count(cluster_count)
     , _clusterflags(master._clusterflags)
+    , _advances(advances)
+    , _y(y)
+    , _cluster_x(cluster_x)
+    , _cluster_bytes(cluster_bytes)
    {
       CYCFI_ASSERT(_first, "Precondition failure: _first must not be null");
       CYCFI_ASSERT(_last, "Precondition failure: _last must not be null");
       CYCFI_ASSERT(_scaled_font, "Precondition failure: _scaled_font must not be null");
-      CYCFI_ASSERT(_glyphs, "Precondition failure: _glyphs must not be null");
-      CYCFI_ASSERT(_clusters, "Precondition failure: _clusters must not be null");
+      CYCFI_ASSERT(_glyphs || !_glyph_count, "Precondition failure: _glyphs must not be null");
+      CYCFI_ASSERT(_clusters || !_cluster_count, "Precondition failure: _clusters must not be null");
+      CYCFI_ASSERT(_advances || !_glyph_count, "Precondition failure: _advances must not be null");
 
       // We strip leading spaces until after the last leading newline.
       // Examples:
@@ -49,29 +63,26 @@ namespace cycfi { namespace elements
 
       auto  strip_leading = [this](auto f)
       {
-         int      glyph_index = 0;
-         unsigned codepoint;
-         unsigned state = 0;
-
-         cairo_text_cluster_t* cluster = _clusters;
-         for (auto i = _first; i != _last; ++i)
+         int         glyph_index = 0;
+         int         clusters_skipped = 0;
+         char const* utf8 = _first;
+         for (; clusters_skipped != _cluster_count; ++clusters_skipped)
          {
-            if (!decode_utf8(state, codepoint, uint8_t(*i)))
-            {
-               if (!f(codepoint))
-                  break;
-               glyph_index += cluster->num_glyphs;
-               ++cluster;
-            }
+            char const* p = utf8;
+            if (!f(codepoint(p)))
+               break;
+            glyph_index += _clusters[clusters_skipped].num_glyphs;
+            utf8 += _clusters[clusters_skipped].num_bytes;
          }
 
-         auto   clusters_skipped = int(cluster - _clusters);
-
          _glyph_count -= glyph_index;
          _glyphs += glyph_index;
+         _advances += glyph_index;
          _cluster_count -= clusters_skipped;
-         _clusters = cluster;
-         _first += clusters_skipped;
+         _clusters += clusters_skipped;
+         _cluster_x += clusters_skipped;
+         _cluster_bytes += clusters_skipped;
+         _first = _cluster_count? utf8 : _last;
       };
 
       if (strip_leading_spaces)
@@ -79,7 +90,43 @@ namespace cycfi { namespace elements
       strip_leading([](auto cp){ return is_newline(cp); });
    }
 
-   void glyphs::draw(point pos, canvas& canvas_)
+   char const* glyphs::hit(float x) const
+   {
+      if (!_cluster_x)
+         return _last;
+
+      // The first cluster whose right edge is past x
+      auto start_x = _cluster_x[0];
+      auto end = _cluster_x + _cluster_count + 1;
+      auto i = std::upper_bound(_cluster_x + 1, end, x + start_x);
+      if (i == end)
+         return _last;
+      return _first + (_cluster_bytes[(i - _cluster_x) - 1] - _cluster_bytes[0]);
+   }
+
+   glyphs::glyph_position glyphs::position(char const* utf8) const
+   {
+      if (!_cluster_bytes)
+         return { _last, 0, 0 };
+
+      auto start_x = _cluster_x[0];
+      auto start = _cluster_bytes[0];
+      auto i = std::lower_bound(
+         _cluster_bytes, _cluster_bytes + _cluster_count, int(utf8 - _first) + start);
+      auto n = i - _cluster_bytes;
+      if (n == _cluster_count)
+      {
+         auto end_x = _cluster_x[n] - start_x;
+         return { _last, end_x, end_x };
+      }
+      return {
+         _first + (*i - start)
+       , _cluster_x[n] - start_x
+       , _cluster_x[n + 1] - start_x
+      };
+   }
+
+   void glyphs::draw(point pos, canvas& canvas_) const
    {
       // return early if there's nothing to draw
       if (_first == _last)
@@ -114,10 +161,8 @@ namespace cycfi { namespace elements
 
       if (_glyph_count)
       {
-         cairo_text_extents_t extents;
-         auto glyph = _glyphs + _glyph_count -1;
-         cairo_scaled_font_glyph_extents(_scaled_font, glyph, 1, &extents);
-         return (glyph->x + extents.x_advance) - _glyphs->x;
+         auto last = _glyph_count - 1;
+         return (_glyphs[last].x + _advances[last]) - _glyphs->x;
       }
       return 0;
    }
@@ -145,7 +190,7 @@ namespace cycfi { namespace elements
       cnv.font(face, size);
       auto cr = scratch_context_.context();
       _scaled_font = cairo_scaled_font_reference(cairo_get_scaled_font(cr));
-      build();
+      build(0, 0, _first, _last);
    }
 
    master_glyphs::master_glyphs(char const* first, char const* last, master_glyphs const& source)
@@ -153,77 +198,170 @@ namespace cycfi { namespace elements
    {
       canvas cnv{ *scratch_context_.context() };
       _scaled_font = cairo_scaled_font_reference(source._scaled_font);
-      build();
+      build(0, 0, _first, _last);
    }
 
    master_glyphs::master_glyphs(master_glyphs&& rhs)
     : glyphs(rhs._first, rhs._last)
+    , _paragraphs(std::move(rhs._paragraphs))
+    , _starts_valid(rhs._starts_valid)
+    , _edited(rhs._edited)
+    , _edit_first(rhs._edit_first)
+    , _edit_last(rhs._edit_last)
+    , _edit_delta(rhs._edit_delta)
+    , _lines_width(rhs._lines_width)
+    , _lines(std::move(rhs._lines))
+    , _spans(std::move(rhs._spans))
    {
       _scaled_font = rhs._scaled_font;
-      _glyphs = rhs._glyphs;
-      _glyph_count = rhs._glyph_count;
-      _clusters = rhs._clusters;
-      _cluster_count = rhs._cluster_count;
       _clusterflags = rhs._clusterflags;
 
-      rhs._glyphs = nullptr;
-      rhs._clusters = nullptr;
       rhs._scaled_font = nullptr;
+      rhs._paragraphs.clear();
+      rhs._starts_valid = 0;
    }
 
    master_glyphs& master_glyphs::operator=(master_glyphs&& rhs)
    {
       if (&rhs != this)
       {
+         if (_scaled_font)
+            cairo_scaled_font_destroy(_scaled_font);
+
          _first = rhs._first;
          _last = rhs._last;
          _scaled_font = rhs._scaled_font;
-         _glyphs = rhs._glyphs;
-         _glyph_count = rhs._glyph_count;
-         _clusters = rhs._clusters;
-         _cluster_count = rhs._cluster_count;
          _clusterflags = rhs._clusterflags;
+         _paragraphs = std::move(rhs._paragraphs);
+         _starts_valid = rhs._starts_valid;
+         _edited = rhs._edited;
+         _edit_first = rhs._edit_first;
+         _edit_last = rhs._edit_last;
+         _edit_delta = rhs._edit_delta;
+         _lines_width = rhs._lines_width;
+         _lines = std::move(rhs._lines);
+         _spans = std::move(rhs._spans);
 
-         rhs._glyphs = nullptr;
-         rhs._clusters = nullptr;
          rhs._scaled_font = nullptr;
+         rhs._paragraphs.clear();
+         rhs._starts_valid = 0;
       }
       return *this;
    }
 
    master_glyphs::~master_glyphs()
    {
-      if (_glyphs)
-         cairo_glyph_free(_glyphs);
-      if (_clusters)
-         cairo_text_cluster_free(_clusters);
       if (_scaled_font)
          cairo_scaled_font_destroy(_scaled_font);
-
-      _glyphs = nullptr;
-      _clusters = nullptr;
       _scaled_font = nullptr;
    }
 
-   void master_glyphs::text(char const* first, char const* last)
+   void master_glyphs::draw(point pos, canvas& canvas_) const
    {
-      if (_glyphs)
+      // return early if there's nothing to draw
+      if (_first == _last)
+         return;
+
+      CYCFI_ASSERT(_scaled_font, "Precondition failure: _scaled_font must not be null");
+
+      auto cr = &canvas_.cairo_context();
+      auto state = canvas_.new_state();
+
+      cairo_set_scaled_font(cr, _scaled_font);
+      cairo_translate(cr, pos.x, pos.y);
+      canvas_.apply_fill_style();
+
+      // Each paragraph is shaped from x = 0. Move to where it starts.
+      update_starts(_paragraphs.size());
+      float x = 0;
+      for (auto const& para : _paragraphs)
       {
-         cairo_glyph_free(_glyphs);
-         _glyphs = nullptr;
+         if (para.glyphs.empty())
+            continue;
+
+         cairo_translate(cr, para.x - x, 0);
+         x = para.x;
+
+         cairo_show_text_glyphs(
+            cr, _first + para.start, int(para.bytes),
+            para.glyphs.data(), int(para.glyphs.size()),
+            para.clusters.data(), int(para.clusters.size()), _clusterflags
+         );
       }
-      if (_clusters)
+   }
+
+   float master_glyphs::width() const
+   {
+      if (_paragraphs.empty())
+         return 0;
+      update_starts(_paragraphs.size());
+      auto const& para = _paragraphs.back();
+      return para.x + para.width;
+   }
+
+   void master_glyphs::edit(std::size_t pos, std::size_t n, std::size_t size)
+   {
+      auto delta = std::ptrdiff_t(size) - std::ptrdiff_t(n);
+      if (!_edited)
       {
-         cairo_text_cluster_free(_clusters);
-         _clusters = nullptr;
+         _edited = true;
+         _edit_first = pos;
+         _edit_last = pos + size;
+         _edit_delta = delta;
+         return;
       }
 
+      // Merge it with the edits before it. Both ranges are in the
+      // coordinates of the text at the time of the edit.
+      _edit_first = std::min(_edit_first, pos);
+      _edit_last = std::max(_edit_last, pos + n) + delta;
+      _edit_delta += delta;
+   }
+
+   void master_glyphs::text(char const* first, char const* last)
+   {
+      auto old_size = std::size_t(_last - _first);
+      bool edited = _edited;
+      _edited = false;
       _first = first;
       _last = last;
-      build();
+
+      // Shape the whole text if we do not know what changed
+      auto size = std::size_t(_last - _first);
+      if (!edited || _paragraphs.empty()
+         || std::ptrdiff_t(old_size) + _edit_delta != std::ptrdiff_t(size)
+         || _edit_first > old_size || _edit_last > size)
+      {
+         build(0, _paragraphs.size(), _first, _last);
+         return;
+      }
+
+      // The edits start in this paragraph...
+      std::size_t p = find_paragraph(_edit_first);
+
+      // ... and end in the paragraph ending at the first newline after
+      // them. The text after that is unchanged, only moved by _edit_delta.
+      auto from = _first + _paragraphs[p].start;
+      auto to = std::find(_first + _edit_last, _last, '\n');
+      if (to != _last)
+         ++to;
+
+      std::size_t q = _paragraphs.size();
+      if (to != _last)
+      {
+         auto end = std::size_t((to - _first) - _edit_delta);
+         for (q = p; q != _paragraphs.size(); ++q)
+         {
+            update_starts(q + 1);
+            if (_paragraphs[q].start >= end)
+               break;
+         }
+      }
+
+      build(p, q, from, to);
    }
 
-   void master_glyphs::break_lines(float width, std::vector<glyphs>& lines)
+   void master_glyphs::break_lines(float width, line_list& lines)
    {
       CYCFI_ASSERT(_scaled_font, "Precondition failure: _scaled_font must not be null");
 
@@ -231,99 +369,314 @@ namespace cycfi { namespace elements
       if (_first == _last)
          return;
 
-      CYCFI_ASSERT(_glyphs, "Precondition failure: _glyphs must not be null");
-      CYCFI_ASSERT(_clusters, "Precondition failure: _clusters must not be null");
+      auto  font = metrics();
+      auto  line_height = font.ascent + font.descent + font.leading;
+      update_starts(_paragraphs.size());
+      for (auto const& para : _paragraphs)
+         break_paragraph(para, width, line_height, lines, nullptr);
+   }
+
+   void master_glyphs::break_lines(float width)
+   {
+      CYCFI_ASSERT(_scaled_font, "Precondition failure: _scaled_font must not be null");
+
+      auto  font = metrics();
+      auto  line_height = font.ascent + font.descent + font.leading;
+      bool  all = width != _lines_width;
 
-      char const* first = _first;
-      char const* last = _last;
-      char const* space_pos = _first;
+      _lines_width = width;
+      _new_lines.clear();
+      _new_spans.clear();
+
+      if (_first != _last)
+      {
+         update_starts(_paragraphs.size());
+         for (auto& para : _paragraphs)
+         {
+            auto line_start = _new_lines.size();
+            if (all || !para.broken)
+            {
+               break_paragraph(para, width, line_height, _new_lines, &_new_spans);
+            }
+            else
+            {
+               // Keep its lines, moved to where the paragraph now is
+               for (auto i = para.line_start; i != para.line_start + para.line_count; ++i)
+               {
+                  place(_lines[i], para, _spans[i], _new_lines.size() * line_height);
+                  _new_lines.push_back(std::move(_lines[i]));
+                  _new_spans.push_back(_spans[i]);
+               }
+            }
+            para.line_start = line_start;
+            para.line_count = _new_lines.size() - line_start;
+            para.broken = true;
+         }
+      }
+
+      std::swap(_lines, _new_lines);
+      std::swap(_spans, _new_spans);
+   }
+
+   void master_glyphs::break_paragraph(
+      paragraph const& para, float width
+    , float line_height, line_list& lines
+    , line_spans* spans
+   ) const
+   {
+      auto const  glyphs_ = para.glyphs.data();
+      auto const  clusters_ = para.clusters.data();
+      auto const  advances_ = para.advances.data();
+      auto const  cluster_x = para.cluster_x.data();
+      auto const  cluster_bytes = para.cluster_bytes.data();
+      auto const  first_line = lines.size();
+      char const* start = _first + para.start;
+      char const* first = start;
+      char const* space_pos = start;
       int         start_glyph_index = 0;
       int         start_cluster_index = 0;
-      int         space_glyph_index = 0;
-      int         space_cluster_index = 0;
-      float       start_x = _glyphs->x;
+      int         space_glyph_index = start_glyph_index;
+      int         space_cluster_index = start_cluster_index;
+      float       start_x = 0;
 
-      auto add_line = [&]()
+      auto make_line = [&](char const* last, int glyph_end, int cluster_end)
       {
-         glyphs glyph_{
-            first, space_pos
-          , start_glyph_index, space_glyph_index
-          , start_cluster_index, space_cluster_index
+         glyphs line{
+            first, last
+          , glyphs_ + start_glyph_index, glyph_end - start_glyph_index
+          , clusters_ + start_cluster_index, cluster_end - start_cluster_index
+          , advances_ + start_glyph_index
+          , cluster_x + start_cluster_index, cluster_bytes + start_cluster_index
           , *this
-          , lines.size() > 0 // skip leading spaces if this is not the first line
+          , lines.size() != first_line // skip leading spaces if this is not the first line
+          , lines.size() * line_height
          };
-         lines.push_back(std::move(glyph_));
+
+         if (spans)
+         {
+            spans->push_back({
+               std::size_t(line._first - start), std::size_t(line._last - start)
+             , int(line._glyphs - glyphs_)
+             , int(line._clusters - clusters_)
+            });
+         }
+         lines.push_back(std::move(line));
+      };
+
+      auto add_line = [&]()
+      {
+         make_line(space_pos, space_glyph_index, space_cluster_index);
          first = space_pos;
          start_glyph_index = space_glyph_index;
          start_cluster_index = space_cluster_index;
-         start_x = _glyphs[space_glyph_index].x;
+         start_x = glyphs_[space_glyph_index].x;
       };
 
-      int      glyph_index = 0;
-      unsigned codepoint;
-      unsigned state = 0;
-
-      cairo_text_cluster_t* cluster = _clusters;
-      for (auto i = _first; i != _last; ++i)
+      // The glyph positions are already the running sum of the advances,
+      // so wrapping needs no font calls: the line width is exceeded where
+      // a glyph's right edge goes past start_x + width.
+      int         glyph_index = 0;
+      int         i = 0;
+      char const* utf8 = start;
+      for (auto end = int(para.clusters.size()); i != end; ++i)
       {
-         if (!decode_utf8(state, codepoint, uint8_t(*i)))
+         // The newline ends the paragraph's last line
+         if (*utf8 == '\n')
+            break;
+
+         char const* p = utf8;
+         auto        cp = codepoint(p);
+
+         // Check if we exceeded the line width:
+         if ((glyphs_[glyph_index].x + advances_[glyph_index]) - start_x > width)
          {
-            cairo_glyph_t*  glyph = _glyphs + glyph_index;
+            // Add the line if we did (exceed the line width)
+            add_line();
+         }
 
-            // Check if we exceeded the line width:
-            cairo_text_extents_t extents;
-            cairo_scaled_font_glyph_extents(_scaled_font, glyph, 1, &extents);
-            if (((glyph->x + extents.x_advance) - start_x) > width)
-            {
-               // Add the line if we did (exceed the line width)
+         // Did we have a space?
+         else if (is_space(cp))
+         {
+            // Mark the spaces for later
+            space_glyph_index = glyph_index;
+            space_cluster_index = i;
+            space_pos = utf8;
+
+            // If we got an explicit new line, add the line right away.
+            if ((space_glyph_index != start_glyph_index) && is_newline(cp))
                add_line();
-            }
+         }
 
-            // Did we have a space?
-            else if (is_space(codepoint))
-            {
-               // Mark the spaces for later
-               space_glyph_index = glyph_index;
-               space_cluster_index = int(cluster - _clusters);
-               space_pos = i;
-
-               // If we got an explicit new line, add the line right away.
-               if ((space_glyph_index != start_glyph_index) && is_newline(codepoint))
-                  add_line();
-            }
+         glyph_index += clusters_[i].num_glyphs;
+         utf8 += clusters_[i].num_bytes;
+      }
 
-            glyph_index += cluster->num_glyphs;
-            ++cluster;
+      make_line(utf8, glyph_index, i);
+   }
+
+   void master_glyphs::place(
+      glyphs& line, paragraph const& para
+    , line_span const& span, float y
+   ) const
+   {
+      char const* start = _first + para.start;
+      line._first = start + span.first;
+      line._last = start + span.last;
+      line._glyphs = para.glyphs.data() + span.glyph_start;
+      line._advances = para.advances.data() + span.glyph_start;
+      line._clusters = para.clusters.data() + span.cluster_start;
+      line._cluster_x = para.cluster_x.data() + span.cluster_start;
+      line._cluster_bytes = para.cluster_bytes.data() + span.cluster_start;
+      line._y = y;
+   }
+
+   void master_glyphs::update_starts(std::size_t n) const
+   {
+      for (; _starts_valid < n; ++_starts_valid)
+      {
+         auto& para = _paragraphs[_starts_valid];
+         if (_starts_valid == 0)
+         {
+            para.start = 0;
+            para.x = 0;
+         }
+         else
+         {
+            auto const& prev = _paragraphs[_starts_valid - 1];
+            para.start = prev.start + prev.bytes;
+            para.x = prev.x + prev.width;
          }
       }
+   }
 
-      glyphs glyph_{
-         first, last
-       , start_glyph_index, _glyph_count
-       , start_cluster_index, _cluster_count
-       , *this
-       , lines.size() > 1 // skip leading spaces if this is not the first line
-      };
+   std::size_t master_glyphs::find_paragraph(std::size_t pos) const
+   {
+      // Bring the starts up to date only as far as needed: edits are
+      // usually near the previous ones
+      while (_starts_valid != _paragraphs.size()
+         && (_starts_valid == 0 || _paragraphs[_starts_valid - 1].start <= pos))
+      {
+         update_starts(_starts_valid + 1);
+      }
 
-      lines.push_back(std::move(glyph_));
+      auto first = _paragraphs.begin();
+      auto i = std::upper_bound(first, first + _starts_valid, pos,
+         [](std::size_t pos, paragraph const& para) { return pos < para.start; }
+      );
+      return (i - first) - 1;
    }
 
-   void master_glyphs::build()
+   float master_glyphs::shape(char const* first, char const* last, paragraph& para)
    {
-      // reurn early if there's nothing to build
-      if (_first == _last)
-         return;
+      para.glyphs.clear();
+      para.clusters.clear();
+      para.advances.clear();
+      para.cluster_x.clear();
+      para.cluster_bytes.clear();
+
+      if (first == last)
+      {
+         para.cluster_x.push_back(0);
+         para.cluster_bytes.push_back(0);
+         return 0;
+      }
+
+      glyph*   glyphs_ = nullptr;
+      int      glyph_count = 0;
+      cluster* clusters_ = nullptr;
+      int      cluster_count = 0;
 
       auto stat = cairo_scaled_font_text_to_glyphs(
-         _scaled_font, 0, 0, _first, int(_last - _first),
-         &_glyphs, &_glyph_count, &_clusters, &_cluster_count,
+         _scaled_font, 0, 0, first, int(last - first),
+         &glyphs_, &glyph_count, &clusters_, &cluster_count,
          &_clusterflags);
 
       if (stat != CAIRO_STATUS_SUCCESS)
-      {
-         _glyphs = nullptr;
-         _clusters = nullptr;
          throw failed_to_build_master_glyphs{};
+
+      para.glyphs.assign(glyphs_, glyphs_ + glyph_count);
+      para.clusters.assign(clusters_, clusters_ + cluster_count);
+
+      // The advances are measured once here. Widths, line breaks and hit
+      // tests use them from then on.
+      for (int i = 0; i != glyph_count; ++i)
+      {
+         cairo_text_extents_t extents;
+         cairo_scaled_font_glyph_extents(_scaled_font, glyphs_ + i, 1, &extents);
+         para.advances.push_back(float(extents.x_advance));
+      }
+
+      float width = 0;
+      if (glyph_count)
+         width = float(para.glyphs.back().x) + para.advances.back();
+
+      // Index the clusters for the rows: the glyph positions are the
+      // running sum of the advances, so a row's x is relative to the x of
+      // its first cluster
+      int   glyph_index = 0;
+      int   offset = 0;
+      for (int i = 0; i != cluster_count; ++i)
+      {
+         auto x = (glyph_index < glyph_count)? float(glyphs_[glyph_index].x) : width;
+         para.cluster_x.push_back(x);
+         para.cluster_bytes.push_back(offset);
+         glyph_index += clusters_[i].num_glyphs;
+         offset += clusters_[i].num_bytes;
+      }
+      para.cluster_x.push_back(width);
+      para.cluster_bytes.push_back(offset);
+
+      cairo_glyph_free(glyphs_);
+      cairo_text_cluster_free(clusters_);
+      return width;
+   }
+
+   void master_glyphs::build(
+      std::size_t first, std::size_t last
+    , char const* from, char const* to
+   )
+   {
+      // Shape the paragraphs in [from, to), each including its newline.
+      // The text's last paragraph has no newline and may be empty. The
+      // scratch paragraphs hold the data of the paragraphs replaced by the
+      // previous edit: reuse it.
+      std::size_t n = 0;
+      auto&& add = [this, &n](char const* f, char const* l)
+      {
+         if (n == _new_paragraphs.size())
+            _new_paragraphs.emplace_back();
+         auto& para = _new_paragraphs[n++];
+         para.bytes = std::size_t(l - f);
+         para.width = shape(f, l, para);
+         para.line_start = 0;
+         para.line_count = 0;
+         para.broken = false;
+      };
+
+      auto i = from;
+      for (auto nl = std::find(i, to, '\n'); nl != to; nl = std::find(i, to, '\n'))
+      {
+         add(i, nl + 1);
+         i = nl + 1;
       }
+      if (to == _last)
+         add(i, to);
+
+      // Swap them in place of the paragraphs [first, last). The paragraphs
+      // after them keep their data.
+      auto count = last - first;
+      auto pos = _paragraphs.begin() + first;
+      if (count < n)
+         pos = _paragraphs.insert(pos + count, n - count, paragraph{}) - count;
+      std::swap_ranges(_new_paragraphs.begin(), _new_paragraphs.begin() + n, pos);
+      if (count > n)
+         _paragraphs.erase(pos + n, pos + count);
+
+      // Keep the data of a few for the next edit, not of a whole text
+      if (_new_paragraphs.size() > max_spare_paragraphs)
+         _new_paragraphs.resize(max_spare_paragraphs);
+
+      // Where the paragraphs from first on start is updated when needed
+      _starts_valid = std::min(_starts_valid, first);
    }
 }}
@@ -15,8 +15,8 @@ namespace cycfi { namespace elements
          return false;
 
       return
-         (std::max(b.left, b.left) <= std::min(b.right, b.right)) &&
-         (std::max(b.top, b.top) <= std::min(b.bottom, b.bottom))
+         (std::max(a.left, b.left) <= std::min(a.right, b.right)) &&
+         (std::max(a.top, b.top) <= std::min(a.bottom, b.bottom))
          ;
    }
 
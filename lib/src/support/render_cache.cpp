@@ -0,0 +1,221 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/render_cache.hpp>
+#include <elements/support/context.hpp>
+#include <elements/element/element.hpp>
+#include <elements/view.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace cycfi { namespace elements
+{
+   render_cache::~render_cache()
+   {
+      for (auto& en : _entries)
+         en.owner->_cache_entry = nullptr;
+   }
+
+   void render_cache::flush()
+   {
+      for (auto& en : _entries)
+      {
+         release(en);
+         en.stable = 0;
+      }
+   }
+
+   void render_cache::flush(element& e)
+   {
+      if (auto en = e._cache_entry)
+         en->cache->remove(*en);
+   }
+
+   bool render_cache::is_cached(element const& e)
+   {
+      return e._cache_entry && e._cache_entry->image;
+   }
+
+   void render_cache::budget(std::size_t bytes)
+   {
+      _budget = bytes;
+      trim();
+   }
+
+   render_cache::entry& render_cache::add(element& e)
+   {
+      _entries.emplace_front();
+      auto& en = _entries.front();
+      en.cache = this;
+      en.owner = &e;
+      en.pos = _entries.begin();
+      en.wait = stable_frames;
+      e._cache_entry = &en;
+      return en;
+   }
+
+   void render_cache::remove(entry& en)
+   {
+      release(en);
+      en.owner->_cache_entry = nullptr;
+      _entries.erase(en.pos);
+   }
+
+   void render_cache::release(entry& en)
+   {
+      en.image.reset();
+      _size -= en.bytes;
+      en.bytes = 0;
+   }
+
+   void render_cache::trim()
+   {
+      // Drop the least recently drawn pixmaps (but never the most recent
+      // one) until we are within budget
+      for (auto i = _entries.rbegin(); _size > _budget && i != _entries.rend(); ++i)
+      {
+         if (i->pos == _entries.begin())
+            break;
+         if (i->image)
+         {
+            release(*i);
+            i->stable = 0;
+         }
+      }
+   }
+
+   bool render_cache::render(context const& ctx, element& e, entry& en)
+   {
+      // Record what the element draws, at whatever size it draws it. The
+      // view's dirty rect is temporarily set to our bounds (and the
+      // overdraw) so that nothing is culled.
+      auto  limit = ctx.bounds.inset(-max_overdraw, -max_overdraw);
+      auto  surface = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
+      {
+         auto  cr = cairo_create(surface);
+         canvas cnv{ *cr };
+
+         auto save_dirty = ctx.view.dirty_region();
+         ctx.view.dirty(limit);
+         context rctx{ ctx.view, cnv, &e, ctx.bounds };
+         rctx.parent = ctx.parent;
+         _rendering = true;
+         e.draw(rctx);
+         _rendering = false;
+         ctx.view.dirty_region(save_dirty);
+         cairo_destroy(cr);
+      }
+
+      double x, y, w, h;
+      cairo_recording_surface_ink_extents(surface, &x, &y, &w, &h);
+      rect  ink = {
+         float(std::floor(x)), float(std::floor(y))
+       , float(std::ceil(x + w)), float(std::ceil(y + h))
+      };
+
+      auto  pw = std::ceil(ink.width() * en.scale);
+      auto  ph = std::ceil(ink.height() * en.scale);
+      auto  bytes = std::size_t(pw * ph * 4);
+
+      // Nothing drawn, too much drawn outside the bounds, or too big to
+      // be worth caching
+      if (bytes == 0 || !limit.includes(ink) || bytes > _budget)
+      {
+         cairo_surface_destroy(surface);
+         en.uncacheable = true;
+         return false;
+      }
+
+      en.image = std::make_unique<pixmap>(point{ float(pw), float(ph) }, 1 / en.scale);
+      en.area = ink.move(-ctx.bounds.left, -ctx.bounds.top);
+      en.bytes = bytes;
+      {
+         pixmap_context pm_ctx{ *en.image };
+         auto cr = pm_ctx.context();
+         cairo_set_source_surface(cr, surface, -ink.left, -ink.top);
+         cairo_paint(cr);
+      }
+      cairo_surface_destroy(surface);
+
+      _size += bytes;
+      trim();
+      return true;
+   }
+
+   void render_cache::draw(context const& ctx, element& e, mode m)
+   {
+      // Elements drawn while rendering a pixmap are part of that pixmap
+      if (_rendering)
+      {
+         e.draw(ctx);
+         return;
+      }
+
+      auto en = e._cache_entry;
+      if (en && en->cache != this)
+      {
+         // The element moved to another view
+         en->cache->remove(*en);
+         en = nullptr;
+      }
+
+      if (!en)
+      {
+         if (m == always)
+         {
+            en = &add(e);
+         }
+         else
+         {
+            // Automatic caching: time the element and start caching it if
+            // it is slow to draw. Controls are expected to change often.
+            bool  clean = !(e.dirty() & element::paint_dirty);
+            auto  start = std::chrono::steady_clock::now();
+            e.draw(ctx);
+            auto  elapsed = std::chrono::steady_clock::now() - start;
+            if (elapsed >= _threshold && !e.is_control())
+               add(e).stable = clean;
+            return;
+         }
+      }
+
+      // The element's paint was invalidated: drop the pixmap and draw
+      // directly until the element is stable again.
+      auto  bounds = ctx.bounds;
+      if ((e.dirty() & element::paint_dirty)
+         || ctx.view.is_repainted(bounds.inset(-max_overdraw, -max_overdraw)))
+      {
+         if (en->image)
+            en->wait = std::min(en->wait * 2, max_stable_frames);
+         release(*en);
+         en->stable = 0;
+         e.draw(ctx);
+         return;
+      }
+
+      auto& cnv = ctx.canvas;
+      double scx, scy;
+      cairo_surface_get_device_scale(cairo_get_target(&cnv.cairo_context()), &scx, &scy);
+      auto  scale = float(scx);
+      auto  size = extent{ bounds.width(), bounds.height() };
+
+      if (en->scale != scale || en->size != size)
+      {
+         release(*en);
+         en->scale = scale;
+         en->size = size;
+         en->uncacheable = false;
+      }
+
+      _entries.splice(_entries.begin(), _entries, en->pos);
+      if (!en->image && !en->uncacheable && ++en->stable >= en->wait)
+         render(ctx, e, *en);
+
+      if (en->image)
+         cnv.draw(*en->image, en->area.move(bounds.left, bounds.top).top_left());
+      else
+         e.draw(ctx);
+   }
+}}
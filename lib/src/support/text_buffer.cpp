@@ -0,0 +1,84 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/text_buffer.hpp>
+#include <algorithm>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // text_buffer
+   ////////////////////////////////////////////////////////////////////////////
+   namespace
+   {
+      bool is_continuation(char c)
+      {
+         return (std::uint8_t(c) & 0xC0) == 0x80;
+      }
+   }
+
+   void text_buffer::replace(std::size_t pos, std::size_t n, std::string_view text)
+   {
+      erase(pos, n);
+      insert(pos, text);
+   }
+
+   std::string text_buffer::substr(std::size_t pos, std::size_t n) const
+   {
+      return std::string{ view().substr(pos, n) };
+   }
+
+   std::size_t text_buffer::next_char(std::size_t pos) const
+   {
+      auto size_ = size();
+      if (pos >= size_)
+         return size_;
+      while (++pos < size_ && is_continuation(at(pos)))
+         ;
+      return pos;
+   }
+
+   std::size_t text_buffer::prev_char(std::size_t pos) const
+   {
+      if (pos == 0)
+         return 0;
+      pos = std::min(pos, size());
+      while (--pos > 0 && is_continuation(at(pos)))
+         ;
+      return pos;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // string_buffer
+   ////////////////////////////////////////////////////////////////////////////
+   string_buffer::string_buffer(std::string_view text)
+    : _text(text)
+   {}
+
+   void string_buffer::assign(std::string_view text)
+   {
+      _text.assign(text.data(), text.size());
+   }
+
+   void string_buffer::insert(std::size_t pos, std::string_view text)
+   {
+      _text.insert(pos, text.data(), text.size());
+   }
+
+   void string_buffer::erase(std::size_t pos, std::size_t n)
+   {
+      _text.erase(pos, n);
+   }
+
+   void string_buffer::replace(std::size_t pos, std::size_t n, std::string_view text)
+   {
+      _text.replace(pos, n, text.data(), text.size());
+   }
+
+   std::string string_buffer::substr(std::size_t pos, std::size_t n) const
+   {
+      return _text.substr(pos, n);
+   }
+}}
@@ -0,0 +1,141 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/thread_pool.hpp>
+#include <algorithm>
+
+namespace cycfi { namespace elements
+{
+   namespace
+   {
+      std::atomic<thread_pool*> the_app_pool{ nullptr };
+
+      // The pool and queue index of the current worker thread, if any
+      thread_local thread_pool const* current_pool = nullptr;
+      thread_local std::size_t current_index = 0;
+   }
+
+   thread_pool::thread_pool(std::size_t threads)
+   {
+      if (threads == 0)
+         threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+      for (std::size_t i = 0; i != threads; ++i)
+         _queues.push_back(std::make_unique<queue>());
+   }
+
+   void thread_pool::start()
+   {
+      std::call_once(_started, [this]
+      {
+         for (std::size_t i = 0; i != _queues.size(); ++i)
+            _threads.emplace_back([this, i]{ run(i); });
+      });
+   }
+
+   thread_pool::thread_pool(application_tag, std::size_t threads)
+    : thread_pool(threads)
+   {
+      _is_app_pool = true;
+      the_app_pool = this;
+   }
+
+   thread_pool::~thread_pool()
+   {
+      if (_is_app_pool)
+         the_app_pool = nullptr;
+
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         _stop = true;
+      }
+      _cv.notify_all();
+      for (auto& t : _threads)
+         t.join();
+   }
+
+   void thread_pool::submit(task t)
+   {
+      start();
+      auto index = (current_pool == this)?
+         current_index : _next++ % _queues.size();
+      {
+         auto& q = *_queues[index];
+         std::lock_guard<std::mutex> lock(q.mutex);
+         q.tasks.push_back(std::move(t));
+      }
+      // Count the task after it is queued, so that an idle worker is not
+      // woken up before there is a task to take. A busy worker may take
+      // the task first, briefly taking the count below zero.
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         ++_pending;
+      }
+      _cv.notify_one();
+   }
+
+   bool thread_pool::pop(std::size_t index, task& t)
+   {
+      {
+         auto& q = *_queues[index];
+         std::lock_guard<std::mutex> lock(q.mutex);
+         if (!q.tasks.empty())
+         {
+            t = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            return true;
+         }
+      }
+
+      for (std::size_t i = 1; i != _queues.size(); ++i)
+      {
+         auto& q = *_queues[(index + i) % _queues.size()];
+         std::lock_guard<std::mutex> lock(q.mutex);
+         if (!q.tasks.empty())
+         {
+            t = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+         }
+      }
+      return false;
+   }
+
+   void thread_pool::run(std::size_t index)
+   {
+      current_pool = this;
+      current_index = index;
+
+      while (true)
+      {
+         task t;
+         if (pop(index, t))
+         {
+            --_pending;
+            try
+            {
+               t();
+            }
+            catch (...)
+            {
+            }
+            continue;
+         }
+
+         std::unique_lock<std::mutex> lock(_mutex);
+         _cv.wait(lock, [this]{ return _stop || _pending > 0; });
+         if (_stop && _pending <= 0)
+            return;
+      }
+   }
+
+   thread_pool& app_thread_pool()
+   {
+      if (auto* pool = the_app_pool.load())
+         return *pool;
+      static thread_pool pool;
+      return pool;
+   }
+}}
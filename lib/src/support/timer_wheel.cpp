@@ -0,0 +1,183 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/timer_wheel.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace cycfi { namespace elements
+{
+   timer_wheel::timer_wheel(time_point now)
+    : _origin(now)
+   {
+      _lists.fill(nil);
+   }
+
+   std::uint64_t timer_wheel::ticks(time_point t) const
+   {
+      if (t <= _origin)
+         return 0;
+      return std::chrono::duration_cast<duration>(t - _origin).count();
+   }
+
+   timer_wheel::timer_id timer_wheel::add(time_point now, duration delay, function f)
+   {
+      // Round the expiry up to the next tick so that a timer never fires
+      // early, and never in the tick being processed.
+      auto t = std::chrono::ceil<duration>(now - _origin) + std::max(delay, duration{ 0 });
+      auto expiry = std::max<std::uint64_t>(std::max<long long>(t.count(), 0), _current + 1);
+
+      std::uint32_t i;
+      if (_free != nil)
+      {
+         i = _free;
+         _free = _nodes[i].next;
+      }
+      else
+      {
+         i = std::uint32_t(_nodes.size());
+         _nodes.emplace_back();
+      }
+
+      auto& n = _nodes[i];
+      n.f = std::move(f);
+      n.expiry = expiry;
+      link(i);
+      ++_size;
+      return { i, n.generation };
+   }
+
+   bool timer_wheel::cancel(timer_id id)
+   {
+      if (!id || id.index >= _nodes.size())
+         return false;
+      auto& n = _nodes[id.index];
+      if (n.generation != id.generation || n.list == nil)
+         return false;
+      unlink(id.index);
+      release(id.index);
+      return true;
+   }
+
+   void timer_wheel::link(std::uint32_t i)
+   {
+      auto& n = _nodes[i];
+      auto delta = n.expiry > _current ? n.expiry - _current : 0;
+
+      // Level l holds the timers expiring within slots^(l+1) ticks. Timers
+      // beyond the range of the wheel are parked at the farthest slot and
+      // linked again when it cascades.
+      int level = 0;
+      while (level < levels-1 && delta >= (std::uint64_t(1) << (slot_bits * (level+1))))
+         ++level;
+
+      auto expiry = n.expiry;
+      auto range = std::uint64_t(1) << (slot_bits * levels);
+      if (delta >= range)
+         expiry = _current + range - 1;
+
+      auto slot = (expiry >> (slot_bits * level)) & (slots-1);
+      n.list = std::uint32_t(level * slots + slot);
+      n.prev = nil;
+      n.next = _lists[n.list];
+      if (n.next != nil)
+         _nodes[n.next].prev = i;
+      _lists[n.list] = i;
+   }
+
+   void timer_wheel::unlink(std::uint32_t i)
+   {
+      auto& n = _nodes[i];
+      if (n.prev != nil)
+         _nodes[n.prev].next = n.next;
+      else
+         _lists[n.list] = n.next;
+      if (n.next != nil)
+         _nodes[n.next].prev = n.prev;
+      n.prev = n.next = n.list = nil;
+   }
+
+   void timer_wheel::release(std::uint32_t i)
+   {
+      auto& n = _nodes[i];
+      n.f = nullptr;
+      if (++n.generation == 0)
+         n.generation = 1;
+      n.next = _free;
+      _free = i;
+      --_size;
+   }
+
+   void timer_wheel::cascade(int level)
+   {
+      auto slot = (_current >> (slot_bits * level)) & (slots-1);
+      auto& head = _lists[level * slots + slot];
+      auto i = head;
+      head = nil;
+      while (i != nil)
+      {
+         auto next = _nodes[i].next;
+         link(i);
+         i = next;
+      }
+   }
+
+   void timer_wheel::advance(time_point now, function_list& expired)
+   {
+      auto target = ticks(now);
+      while (_current < target)
+      {
+         if (_size == 0)
+         {
+            _current = target;
+            break;
+         }
+
+         ++_current;
+
+         // When the index of a level wraps around, the next slot of the
+         // level above is distributed to the levels below.
+         for (int level = 1; level < levels; ++level)
+         {
+            if (_current & ((std::uint64_t(1) << (slot_bits * level)) - 1))
+               break;
+            cascade(level);
+         }
+
+         auto& head = _lists[_current & (slots-1)];
+         while (head != nil)
+         {
+            auto i = head;
+            unlink(i);
+            expired.push_back(std::move(_nodes[i].f));
+            release(i);
+         }
+      }
+   }
+
+   timer_wheel::time_point timer_wheel::next_expiry() const
+   {
+      if (_size == 0)
+         return time_point::max();
+
+      // Level 0 gives the exact expiry. The higher levels give the time
+      // their next occupied slot cascades.
+      auto result = std::numeric_limits<std::uint64_t>::max();
+      for (int level = 0; level < levels; ++level)
+      {
+         auto shift = slot_bits * level;
+         auto base = _current >> shift;
+         for (std::uint64_t k = 1; k <= slots; ++k)
+         {
+            if (_lists[level * slots + ((base + k) & (slots-1))] != nil)
+            {
+               result = std::min(result, (base + k) << shift);
+               break;
+            }
+         }
+      }
+      return _origin + duration(result);
+   }
+}}
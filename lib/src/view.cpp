@@ -5,7 +5,10 @@
 =============================================================================*/
 #include <elements/view.hpp>
 #include <elements/window.hpp>
+#include <elements/element/popup.hpp>
 #include <elements/support/context.hpp>
+#include <cmath>
+#include <iostream>
 
  namespace cycfi { namespace elements
  {
@@ -128,16 +131,31 @@
 
    view::view(extent size_)
     : base_view(size_)
+    , _damage(cairo_region_create())
+    , _repaint(cairo_region_create())
+    , _frame_repaint(cairo_region_create())
+    , _measure_surface(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1))
+    , _measure_context(cairo_create(_measure_surface))
     , _work(_io)
    {}
 
    view::view(host_view_handle h)
     : base_view(h)
+    , _damage(cairo_region_create())
+    , _repaint(cairo_region_create())
+    , _frame_repaint(cairo_region_create())
+    , _measure_surface(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1))
+    , _measure_context(cairo_create(_measure_surface))
     , _work(_io)
    {}
 
    view::view(window& win)
     : base_view(win.host())
+    , _damage(cairo_region_create())
+    , _repaint(cairo_region_create())
+    , _frame_repaint(cairo_region_create())
+    , _measure_surface(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1))
+    , _measure_context(cairo_create(_measure_surface))
     , _work(_io)
    {
       on_change_limits = [&win](view_limits limits_)
@@ -148,7 +166,19 @@
 
    view::~view()
    {
+      // Destroy the content while the view is intact: the elements may
+      // unregister from it (e.g. the shortcuts of menus).
+      _content.clear();
+      {
+         std::lock_guard<std::mutex> lock(_async_target->mutex);
+         _async_target->target = nullptr;
+      }
       _io.stop();
+      cairo_region_destroy(_damage);
+      cairo_region_destroy(_repaint);
+      cairo_region_destroy(_frame_repaint);
+      cairo_destroy(_measure_context);
+      cairo_surface_destroy(_measure_surface);
    }
 
    bool view::set_limits()
@@ -156,9 +186,8 @@
       if (_content.empty())
          return false;
 
-      auto surface_ = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
-      auto context_ = cairo_create(surface_);
-      canvas cnv{ *context_ };
+      _content.clear_dirty(element::limits_dirty);
+      canvas cnv{ *_measure_context };
       bool resized = false;
 
       // Update the limits and constrain the window size to the limits
@@ -171,9 +200,6 @@
          if (on_change_limits)
             on_change_limits(limits_);
       }
-
-      cairo_surface_destroy(surface_);
-      cairo_destroy(context_);
       return resized;
    }
 
@@ -182,12 +208,31 @@
       if (_content.empty())
          return;
 
+      // Collect the damaged rectangles from the clip. Fall back to the
+      // bounding rect if the clip is not representable as rectangles.
       _dirty = dirty_;
+      _dirty_rects.clear();
+      auto clip_rects = cairo_copy_clip_rectangle_list(context_);
+      if (clip_rects->status == CAIRO_STATUS_SUCCESS)
+      {
+         for (int i = 0; i != clip_rects->num_rectangles; ++i)
+         {
+            auto const& r = clip_rects->rectangles[i];
+            _dirty_rects.push_back(
+               { float(r.x), float(r.y), float(r.x + r.width), float(r.y + r.height) });
+         }
+      }
+      cairo_rectangle_list_destroy(clip_rects);
+      if (_dirty_rects.empty())
+         _dirty_rects.push_back(_dirty);
 
-      // Update the limits and constrain the window size to the limits
+      // Update the limits and constrain the window size to the limits.
+      // The limits are computed on every draw: not every element that
+      // changes its limits (e.g. labels after a new text) invalidates.
       if (set_limits())
       {
-         refresh();
+         _content.mark_dirty(element::layout_dirty);
+         damage();
          return;
       }
 
@@ -195,32 +240,44 @@
       auto size_ = size();
       rect subj_bounds = { 0, 0, size_.x, size_.y };
       context ctx{ *this, cnv, &_content, subj_bounds };
+      ctx.visible = min(_dirty, subj_bounds);
 
-      // layout the subject only if the window bounds changes
+      // layout the subject only if the window bounds changes or if the
+      // layout was invalidated
       if (subj_bounds != _current_bounds)
       {
          _current_bounds = subj_bounds;
+         _content.mark_dirty(element::layout_dirty);
+      }
+
+      if (_content.dirty() & element::layout_dirty)
+      {
+         elements_moved();
+         _content.clear_dirty(element::layout_dirty);
          _content.layout(ctx);
       }
 
       // draw the subject
       _content.draw(ctx);
+      _content.clear_dirty(element::paint_dirty);
+
+      cairo_region_destroy(_frame_repaint);
+      _frame_repaint = cairo_region_create();
    }
 
    namespace
    {
       template <typename F, typename This>
-      void call(F f, This& self, rect _current_bounds)
+      void call(F f, This& self, cairo_t& context_, rect _current_bounds)
       {
-         auto surface_ = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
-         auto context_ = cairo_create(surface_);
-         canvas cnv{ *context_ };
+         // The measurement context is reused across events (calls may
+         // nest, e.g. a layout triggered from a click). Save and restore
+         // its state so that each call starts from a clean slate.
+         cairo_save(&context_);
+         canvas cnv{ context_ };
          context ctx { self, cnv, &self.content(), _current_bounds };
-
          f(ctx, self.content());
-
-         cairo_surface_destroy(surface_);
-         cairo_destroy(context_);
+         cairo_restore(&context_);
       }
    }
 
@@ -229,12 +286,22 @@
       if (_current_bounds.is_empty())
          return;
 
+      // An explicit layout request lays out everything: the content may
+      // have changed without being invalidated (see layout(element&) for
+      // laying out just the elements that changed).
+      _content.invalidate(nullptr, element::all_dirty);
+
+      elements_moved();
       call(
-         [](auto const& ctx, auto& _content) { _content.layout(ctx); },
-         *this, _current_bounds
+         [](auto const& ctx, auto& _content)
+         {
+            _content.clear_dirty(element::layout_dirty);
+            _content.layout(ctx);
+         },
+         *this, *_measure_context, _current_bounds
       );
 
-      refresh();
+      damage();
    }
 
    void view::layout(element &element)
@@ -242,34 +309,159 @@
       if (_current_bounds.is_empty())
          return;
 
+      // Mark the element and all its ancestors for layout. Elements not
+      // in the path to the element are left alone.
+      _content.invalidate(&element, element::layout_dirty);
+
+      elements_moved();
       call(
-         [](auto const& ctx, auto& _content) { _content.layout(ctx); },
-         *this, _current_bounds
+         [](auto const& ctx, auto& _content)
+         {
+            _content.clear_dirty(element::layout_dirty);
+            _content.layout(ctx);
+         },
+         *this, *_measure_context, _current_bounds
       );
 
       refresh(element);
    }
 
-   void view::refresh()
+   namespace
    {
-      // Allow refresh to be called from another thread
-      _io.post(
-         [this]()
+      cairo_rectangle_int_t to_region_rect(rect area)
+      {
+         int left = std::floor(area.left);
+         int top = std::floor(area.top);
+         return
          {
-            base_view::refresh();
-         }
-      );
+            left, top,
+            int(std::ceil(area.right)) - left,
+            int(std::ceil(area.bottom)) - top
+         };
+      }
+   }
+
+   void view::refresh()
+   {
+      // The whole view changed: the captured bounds may be stale
+      release_pointer();
+      damage();
    }
 
    void view::refresh(rect area)
    {
-      // Allow refresh to be called from another thread
-      _io.post(
-         [this, area]()
+      if (area.is_empty())
+         return;
+      {
+         std::lock_guard<std::mutex> lock(_damage_mutex);
+         auto r = to_region_rect(area);
+         cairo_region_union_rectangle(_repaint, &r);
+      }
+      damage(area);
+   }
+
+   bool view::is_repainted(rect area) const
+   {
+      auto r = to_region_rect(area);
+      return cairo_region_contains_rectangle(_frame_repaint, &r) != CAIRO_REGION_OVERLAP_OUT;
+   }
+
+   void view::damage()
+   {
+      // Allow refresh to be called from another thread. The request is
+      // accumulated and flushed once per frame (see flush_damage).
+      std::lock_guard<std::mutex> lock(_damage_mutex);
+      if (!_damage_all && cairo_region_is_empty(_damage))
+         wake();
+      _damage_all = true;
+   }
+
+   void view::damage(rect area)
+   {
+      // Allow refresh to be called from another thread. The request is
+      // accumulated and flushed once per frame (see flush_damage).
+      std::lock_guard<std::mutex> lock(_damage_mutex);
+      if (_damage_all || area.is_empty())
+         return;
+      if (cairo_region_is_empty(_damage))
+         wake();
+
+      auto r = to_region_rect(area);
+      cairo_region_union_rectangle(_damage, &r);
+   }
+
+   namespace
+   {
+      // Beyond this number of rectangles, we refresh the bounding box
+      constexpr int max_damage_rects = 8;
+
+      // If the rectangles cover at least this fraction of their bounding
+      // box, we refresh the bounding box instead.
+      constexpr double damage_coverage = 0.75;
+   }
+
+   void view::flush_damage()
+   {
+      cairo_region_t* damage = nullptr;
+      bool all = false;
+      {
+         std::lock_guard<std::mutex> lock(_damage_mutex);
+
+         // The explicit repaints go with the frame that draws them
+         cairo_region_union(_frame_repaint, _repaint);
+         cairo_region_destroy(_repaint);
+         _repaint = cairo_region_create();
+
+         all = _damage_all;
+         _damage_all = false;
+         if (!all && cairo_region_is_empty(_damage))
+            return;
+         damage = _damage;
+         _damage = cairo_region_create();
+      }
+
+      if (all)
+      {
+         base_view::refresh();
+      }
+      else
+      {
+         cairo_rectangle_int_t ext;
+         cairo_region_get_extents(damage, &ext);
+         int n = cairo_region_num_rectangles(damage);
+
+         double area = 0;
+         for (int i = 0; i != n; ++i)
          {
-            base_view::refresh(area);
+            cairo_rectangle_int_t r;
+            cairo_region_get_rectangle(damage, i, &r);
+            area += double(r.width) * r.height;
          }
-      );
+
+         auto to_rect = [](cairo_rectangle_int_t const& r)
+         {
+            return rect{
+               float(r.x), float(r.y)
+             , float(r.x + r.width), float(r.y + r.height)
+            };
+         };
+
+         if (n > max_damage_rects
+            || area >= damage_coverage * double(ext.width) * ext.height)
+         {
+            base_view::refresh(to_rect(ext));
+         }
+         else
+         {
+            for (int i = 0; i != n; ++i)
+            {
+               cairo_rectangle_int_t r;
+               cairo_region_get_rectangle(damage, i, &r);
+               base_view::refresh(to_rect(r));
+            }
+         }
+      }
+      cairo_region_destroy(damage);
    }
 
    void view::refresh(element& element, int outward)
@@ -277,7 +469,7 @@
       if (_current_bounds.is_empty())
          return;
 
-      _io.post(
+      post(
          [this, &element, outward]()
          {
             call(
@@ -285,7 +477,7 @@
                {
                   _content.refresh(ctx, element, outward);
                },
-               *this, _current_bounds
+               *this, *_measure_context, _current_bounds
             );
          }
       );
@@ -293,6 +485,19 @@
 
    void view::refresh(context const& ctx, int outward)
    {
+      // Looking up the parameter targets (see drain_parameters). Record
+      // the path on the way.
+      if (_recording_paths && outward == 0 && ctx.element)
+      {
+         auto& path = _parameter_paths[ctx.element];
+         path.elements.clear();
+         for (auto p = &ctx; p; p = p->parent)
+            if (p->element)
+               path.elements.push_back(p->element);
+         std::reverse(path.elements.begin(), path.elements.end());
+         path.bounds = ctx.bounds;
+      }
+
       context const* ctx_ptr = &ctx;
       while (outward > 0 && ctx_ptr)
       {
@@ -300,7 +505,70 @@
          ctx_ptr = ctx_ptr->parent;
       }
       if (ctx_ptr)
-         refresh(ctx_ptr->bounds);
+      {
+         if (ctx_ptr->element)
+            ctx_ptr->element->invalidate(*ctx_ptr, element::paint_dirty);
+         damage(ctx_ptr->bounds);
+      }
+   }
+
+   bool view::scroll_area(rect area, point offset)
+   {
+      area = min(area, _current_bounds);
+      if (area.is_empty() || (offset.x == 0 && offset.y == 0))
+         return true;
+
+      // The offset must be a whole number of pixels
+      if (offset.x != std::round(offset.x) || offset.y != std::round(offset.y))
+         return false;
+
+      // The contents moved by at least the size of the area. Nothing to
+      // move, everything is exposed.
+      if (std::abs(offset.x) >= area.width() || std::abs(offset.y) >= area.height())
+         return false;
+
+      // Popups above the area would be moved along with the contents
+      for (std::size_t i = 0; i != _content.size(); ++i)
+      {
+         if (auto* popup = dynamic_cast<basic_popup_element*>(&_content.at(i)))
+            if (intersects(popup->bounds(), area))
+               return false;
+      }
+
+      // Only whole pixels can be moved. Shrink the area to whole pixels
+      // and refresh the partial pixels at the edges.
+      rect inner = {
+         std::ceil(area.left), std::ceil(area.top),
+         std::floor(area.right), std::floor(area.bottom)
+      };
+
+      // Pending refreshes must be moved too. Let the host have them first.
+      flush_damage();
+      if (!base_view::scroll_area(inner, offset))
+         return false;
+
+      if (inner.left > area.left)
+         damage(rect{ area.left, area.top, inner.left, area.bottom });
+      if (inner.right < area.right)
+         damage(rect{ inner.right, area.top, area.right, area.bottom });
+      if (inner.top > area.top)
+         damage(rect{ area.left, area.top, area.right, inner.top });
+      if (inner.bottom < area.bottom)
+         damage(rect{ area.left, inner.bottom, area.right, area.bottom });
+      area = inner;
+
+      // Refresh the exposed strips
+      if (offset.y > 0)
+         damage(rect{ area.left, area.top, area.right, area.top + offset.y });
+      else if (offset.y < 0)
+         damage(rect{ area.left, area.bottom + offset.y, area.right, area.bottom });
+
+      if (offset.x > 0)
+         damage(rect{ area.left, area.top, area.left + offset.x, area.bottom });
+      else if (offset.x < 0)
+         damage(rect{ area.right + offset.x, area.top, area.right, area.bottom });
+
+      return true;
    }
 
    void view::click(mouse_button btn)
@@ -309,13 +577,18 @@
       if (_content.empty())
          return;
 
+      // Presses and releases always go through the tree. The composites
+      // on the way keep track of the element clicked (and dragged) until
+      // the release. Only the drags in between use the captured path.
+      release_pointer();
+
       call(
          [btn, this](auto const& ctx, auto& _content)
          {
             _content.click(ctx, btn);
             _is_focus = _content.focus();
          },
-         *this, _current_bounds
+         *this, *_measure_context, _current_bounds
       );
    }
 
@@ -325,12 +598,63 @@
       if (_content.empty())
          return;
 
+      if (!_pointer_capture.empty())
+      {
+         cairo_save(_measure_context);
+         auto& ctx = _pointer_capture[_capture_start];
+         ctx.element->drag(ctx, btn);
+         cairo_restore(_measure_context);
+         return;
+      }
+
       call(
          [btn](auto const& ctx, auto& _content) { _content.drag(ctx, btn); },
-         *this, _current_bounds
+         *this, *_measure_context, _current_bounds
       );
    }
 
+   void view::elements_moved()
+   {
+      release_pointer();
+      _parameter_paths.clear();
+   }
+
+   void view::capture_pointer(context const& ctx)
+   {
+      // Only while a button is down, and the first capture wins
+      if (!_current_button.down || !_pointer_capture.empty())
+         return;
+
+      std::size_t depth = 0;
+      for (auto p = &ctx; p; p = p->parent)
+         ++depth;
+
+      // Rebuild the path root first. The parents of the recorded contexts
+      // point into the vector, so it must not reallocate.
+      _pointer_capture.reserve(depth);
+      for (std::size_t i = depth; i != 0; --i)
+      {
+         auto p = &ctx;
+         for (auto n = i - 1; n != 0; --n)
+            p = p->parent;
+
+         if (_pointer_capture.empty())
+            _pointer_capture.emplace_back(*this, _capture_canvas, p->element, p->bounds);
+         else
+            _pointer_capture.emplace_back(_pointer_capture.back(), p->element, p->bounds);
+         _pointer_capture.back().visible = p->visible;
+      }
+
+      _capture_start = 0;
+      while (_capture_start + 1 < _pointer_capture.size())
+      {
+         auto e = _pointer_capture[_capture_start].element;
+         if (e && !e->forwards_drag())
+            break;
+         ++_capture_start;
+      }
+   }
+
    void view::cursor(point p, cursor_tracking status)
    {
       if (_content.empty())
@@ -342,7 +666,7 @@
             if (!_content.cursor(ctx, p, status))
                set_cursor(cursor_type::arrow);
          },
-         *this, _current_bounds
+         *this, *_measure_context, _current_bounds
       );
    }
 
@@ -353,21 +677,61 @@
 
       call(
          [dir, p](auto const& ctx, auto& _content) { _content.scroll(ctx, dir, p); },
-         *this, _current_bounds
+         *this, *_measure_context, _current_bounds
       );
    }
 
    void view::key(key_info const& k)
    {
+      _accelerator_tried = false;
       if (_content.empty())
+      {
+         accelerator(k);
          return;
+      }
 
       call(
          [k](auto const& ctx, auto& _content) { _content.key(ctx, k); },
-         *this, _current_bounds
+         *this, *_measure_context, _current_bounds
       );
    }
 
+   view::accelerator_id view::add_accelerator(
+      shortcut_key k, accelerator_function f, element const* scope)
+   {
+      return _accelerators.add(k, std::move(f), scope);
+   }
+
+   bool view::remove_accelerator(accelerator_id id)
+   {
+      return _accelerators.remove(id);
+   }
+
+   bool view::accelerator(key_info const& k)
+   {
+      if (_accelerator_tried ||
+         (k.action != key_action::press && k.action != key_action::repeat))
+         return false;
+      _accelerator_tried = true;
+
+      // A scope ranks by its position in the layers, topmost highest.
+      // Scopes that are not open are inactive.
+      auto rank = [this](element const* scope) -> int
+      {
+         for (std::size_t ix = _content.size(); ix != 0; --ix)
+            if (&_content.at(ix-1) == scope)
+               return int(ix);
+         return -1;
+      };
+
+      // The accelerator runs once per folded key repeat
+      if (!_accelerators.call(shortcut_of(k), rank))
+         return false;
+      for (int i = 1; i < k.count; ++i)
+         _accelerators.call(shortcut_of(k), rank);
+      return true;
+   }
+
    void view::text(text_info const& info)
    {
       if (_content.empty())
@@ -375,28 +739,29 @@
 
       call(
          [info](auto const& ctx, auto& _content) { _content.text(ctx, info); },
-         *this, _current_bounds
+         *this, *_measure_context, _current_bounds
       );
    }
 
    void view::add_undo(undo_redo_task f)
    {
-      _undo_stack.push(f);
-      if (has_redo())
-      {
-         // clear the redo stack
-         undo_stack_type empty{};
-         _redo_stack.swap(empty);
-      }
+      // clear the redo stack
+      for (auto const& t : _redo_stack)
+         _undo_size -= t.size;
+      _redo_stack.clear();
+
+      _undo_size += f.size;
+      _undo_stack.push_back(std::move(f));
+      trim_undo();
    }
 
    bool view::undo()
    {
       if (has_undo())
       {
-         auto t = _undo_stack.top();
-         _undo_stack.pop();
-         _redo_stack.push(t);
+         auto t = _undo_stack.back();
+         _undo_stack.pop_back();
+         _redo_stack.push_back(t);
          t.undo();  // execute undo function
          return true;
       }
@@ -407,45 +772,335 @@
    {
       if (has_redo())
       {
-         auto t = _redo_stack.top();
-         _undo_stack.push(t);
-         _redo_stack.pop();
+         auto t = _redo_stack.back();
+         _undo_stack.push_back(t);
+         _redo_stack.pop_back();
          t.redo();  // execute redo function
          return true;
       }
       return false;
    }
 
+   void view::undo_budget(std::size_t bytes)
+   {
+      _undo_budget = bytes;
+      trim_undo();
+   }
+
+   void view::trim_undo()
+   {
+      // Drop the oldest history first. The latest undo is always kept,
+      // whatever its size.
+      while (_undo_size > _undo_budget && !_redo_stack.empty())
+      {
+         _undo_size -= _redo_stack.front().size;
+         _redo_stack.pop_front();
+      }
+      while (_undo_size > _undo_budget && _undo_stack.size() > 1)
+      {
+         _undo_size -= _undo_stack.front().size;
+         _undo_stack.pop_front();
+      }
+   }
+
    void view::focus(focus_request r)
    {
       if (_content.empty() || !_is_focus)
          return;
 
       _content.focus(r);
-      refresh();
+      damage();
    }
 
    void view::content(layers_type&& layers)
    {
+      elements_moved();
       _content = std::forward<layers_type>(layers);
       std::reverse(_content.begin(), _content.end());
+      _content.mark_dirty(element::all_dirty);
       set_limits();
    }
 
    void view::poll()
    {
+      drain_parameters();
+      run_timers();
+      run_animations();
       _io.poll();
-      if (_tracking_state != tracking::none)
+      flush_damage();
+   }
+
+   view::animation_id view::animate(
+      element& e, animator::duration d
+    , animator::update_function f
+    , easing::function ease
+    , int property
+    , animator::done_function done
+   )
+   {
+      auto id = _animator.add(&e, d, std::move(f), ease, property, std::move(done));
+      wake();
+      return id;
+   }
+
+   bool view::cancel_animation(animation_id id)
+   {
+      return _animator.cancel(id);
+   }
+
+   void view::run_animations()
+   {
+      if (!_animator.active())
+         return;
+
+      _animator.tick(animator::clock::now(), _animated);
+
+      // Limit the damage to the bounds of the animated elements
+      if (!_animated.empty() && !_current_bounds.is_empty())
       {
-         using namespace std::chrono_literals;
-         auto now = std::chrono::steady_clock::now();
-         if ((now - _tracking_time) > 1s)
+         std::sort(_animated.begin(), _animated.end());
+         _animated.erase(std::unique(_animated.begin(), _animated.end()), _animated.end());
+         call(
+            [this](auto const& ctx, auto& _content)
+            {
+               _content.refresh(ctx, _animated);
+            },
+            *this, *_measure_context, _current_bounds
+         );
+
+         // Animated elements may have moved
+         elements_moved();
+      }
+      _animated.clear();
+
+      // Keep the frames coming while there are active animations
+      if (_animator.active())
+         wake();
+   }
+
+   view::timer_id view::add_timer(timer_wheel::duration delay, timer_wheel::function f)
+   {
+      // Timers may be added from any thread
+      auto now = timer_wheel::clock::now();
+      std::lock_guard<std::mutex> lock(_timers_mutex);
+      auto id = _timers.add(now, delay, std::move(f));
+
+      // Ask the host for a wakeup only if this timer expires before the
+      // one we are already waiting for
+      auto next = _timers.next_expiry();
+      if (next < _timers_armed)
+      {
+         _timers_armed = next;
+         wake(std::chrono::ceil<timer_wheel::duration>(next - now));
+      }
+      return id;
+   }
+
+   bool view::cancel(timer_id id)
+   {
+      std::lock_guard<std::mutex> lock(_timers_mutex);
+      return _timers.cancel(id);
+   }
+
+   void view::unhandled_async_error(std::exception_ptr error)
+   {
+      try
+      {
+         std::rethrow_exception(error);
+      }
+      catch (std::exception const& e)
+      {
+         std::cerr << "elements: unhandled exception in async work: "
+            << e.what() << std::endl;
+      }
+      catch (...)
+      {
+         std::cerr << "elements: unhandled exception in async work" << std::endl;
+      }
+      std::terminate();
+   }
+
+   void view::paste_clipboard(std::weak_ptr<void> owner, clipboard_chunk_function f)
+   {
+      using namespace std::chrono_literals;
+      clipboard_async(
+         [target = _async_target, owner, f = std::move(f)](std::string text) mutable
          {
-            on_tracking(*_tracking_element, tracking::end_tracking);
-            _tracking_time = now;
-            _tracking_element = nullptr;
-            _tracking_state = tracking::none;
+            std::lock_guard<std::mutex> lock(target->mutex);
+            if (!target->target)
+               return;
+            auto p = std::make_shared<clipboard_paste>(
+               clipboard_paste{ std::move(owner), std::move(f), std::move(text) });
+
+            // Start on the next frame, even if the host called us right away
+            // from the element that asked for the paste
+            auto& v = *target->target;
+            v.post(0ms, [&v, p]{ v.paste_chunk(p); });
          }
+      );
+   }
+
+   void view::paste_chunk(std::shared_ptr<clipboard_paste> p)
+   {
+      using namespace std::chrono_literals;
+      if (p->owner.expired())
+         return;
+
+      auto text = std::string_view{ p->text }.substr(p->pos);
+      auto n = text.size();
+      if (n > clipboard_chunk_size)
+      {
+         // Do not split a UTF-8 sequence. Invalid text (a chunk of
+         // continuation bytes only) is split anywhere.
+         n = clipboard_chunk_size;
+         while (n > 0 && (uint8_t(text[n]) & 0xC0) == 0x80)
+            --n;
+         if (n == 0)
+            n = clipboard_chunk_size;
+      }
+      p->pos += n;
+
+      bool last = p->pos == p->text.size();
+      p->f(text.substr(0, n), last);
+
+      // The rest goes in the following frames
+      if (!last)
+         post(0ms, [this, p]{ paste_chunk(p); });
+   }
+
+   void view::run_timers()
+   {
+      auto now = timer_wheel::clock::now();
+      {
+         std::lock_guard<std::mutex> lock(_timers_mutex);
+         if (_timers_armed > now && _timers.size())
+            return;
+
+         _timers.advance(now, _expired_timers);
+
+         // Arm the host for the next expiry
+         auto next = _timers.next_expiry();
+         _timers_armed = next;
+         if (next != timer_wheel::time_point::max())
+            wake(std::chrono::ceil<timer_wheel::duration>(next - now));
+      }
+
+      // Call the expired timers without holding the lock. They may add
+      // timers of their own.
+      for (auto& f : _expired_timers)
+         f();
+      _expired_timers.clear();
+   }
+
+   parameter_channel_ptr view::make_parameter_channel(std::size_t capacity)
+   {
+      auto ch = std::make_shared<parameter_channel>(*this, capacity);
+      _parameter_channels.push_back(ch);
+      return ch;
+   }
+
+   bool view::remove_parameter_channel(parameter_channel_ptr const& ch)
+   {
+      auto i = std::find(_parameter_channels.begin(), _parameter_channels.end(), ch);
+      if (i == _parameter_channels.end())
+         return false;
+      _parameter_channels.erase(i);
+      _parameter_paths.clear();
+      return true;
+   }
+
+   void view::drain_parameters()
+   {
+      if (_parameter_channels.empty())
+         return;
+
+      bool active = false;
+      for (auto& ch : _parameter_channels)
+      {
+         active = ch->drain(
+            [this](element& e, double val)
+            {
+               e.value(val);
+               _parameter_targets.push_back(&e);
+            }
+         ) || active;
+      }
+
+      // While the values keep coming, we poll the channels every frame.
+      // The producers do not have to wake us up.
+      if (active)
+         wake();
+
+      // Refresh the elements that changed. Without bounds, there is nothing
+      // to refresh, but we still apply the values.
+      if (!_parameter_targets.empty() && !_current_bounds.is_empty())
+      {
+         std::sort(_parameter_targets.begin(), _parameter_targets.end());
+         _parameter_targets.erase(
+            std::unique(_parameter_targets.begin(), _parameter_targets.end())
+          , _parameter_targets.end()
+         );
+
+         // Refresh through the recorded paths, like refresh(ctx) does
+         _parameter_unmapped.clear();
+         for (auto e : _parameter_targets)
+         {
+            auto i = _parameter_paths.find(e);
+            if (i == _parameter_paths.end())
+            {
+               _parameter_unmapped.push_back(e);
+               continue;
+            }
+            for (auto pe : i->second.elements)
+               pe->mark_dirty(element::paint_dirty);
+            damage(i->second.bounds);
+         }
+
+         // Look up the elements without a path, in one pass through the
+         // tree, recording their paths
+         if (!_parameter_unmapped.empty())
+         {
+            _recording_paths = true;
+            call(
+               [this](auto const& ctx, auto& _content)
+               {
+                  _content.refresh(ctx, _parameter_unmapped);
+               },
+               *this, *_measure_context, _current_bounds
+            );
+            _recording_paths = false;
+
+            // Not in the tree: do not look for them again until the
+            // elements move
+            for (auto e : _parameter_unmapped)
+               _parameter_paths.try_emplace(e);
+         }
+      }
+      _parameter_targets.clear();
+   }
+
+   void view::check_tracking()
+   {
+      using namespace std::chrono_literals;
+      _tracking_check = false;
+      if (_tracking_state == tracking::none)
+         return;
+
+      // End tracking after 1s of inactivity. Otherwise, check again when
+      // the latest activity is 1s old.
+      auto now = std::chrono::steady_clock::now();
+      auto elapsed = now - _tracking_time;
+      if (elapsed >= 1s)
+      {
+         on_tracking(*_tracking_element, tracking::end_tracking);
+         _tracking_time = now;
+         _tracking_element = nullptr;
+         _tracking_state = tracking::none;
+      }
+      else
+      {
+         _tracking_check = true;
+         post(1s - elapsed, [this]{ check_tracking(); });
       }
    }
 
@@ -463,5 +1118,12 @@
       _tracking_state = state;
       _tracking_time = std::chrono::steady_clock::now();
       on_tracking(e, state);
+
+      if (!_tracking_check && _tracking_state != tracking::none)
+      {
+         using namespace std::chrono_literals;
+         _tracking_check = true;
+         post(1s, [this]{ check_tracking(); });
+      }
    }
 }}
@@ -0,0 +1,149 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/accelerator.hpp>
+#include <elements/element/element.hpp>
+#include "check.hpp"
+#include <string>
+
+using namespace cycfi::elements;
+
+namespace
+{
+   shortcut_key const ctrl_s = { key_code::s, mod_control };
+   shortcut_key const ctrl_shift_s = { key_code::s, mod_control | mod_shift };
+
+   auto no_scopes = [](element const*) { return 0; };
+
+   void test_lookup()
+   {
+      accelerator_table table;
+      std::string log;
+
+      table.add(ctrl_s, [&]{ log += "s"; return true; });
+      table.add(ctrl_shift_s, [&]{ log += "S"; return true; });
+      CHECK(table.size() == 2);
+
+      CHECK(table.call(ctrl_s, no_scopes));
+      CHECK(table.call(ctrl_shift_s, no_scopes));
+      CHECK(!table.call({ key_code::s, 0 }, no_scopes));
+      CHECK(!table.call({ key_code::a, mod_control }, no_scopes));
+      CHECK(log == "sS");
+
+      // mod_action comes with the modifier it maps to, and is ignored
+      key_info k = { key_code::s, key_action::press, mod_control | mod_action };
+      CHECK(shortcut_of(k) == ctrl_s);
+   }
+
+   void test_remove()
+   {
+      accelerator_table table;
+      int calls = 0;
+
+      auto id = table.add(ctrl_s, [&]{ ++calls; return true; });
+      CHECK(table.remove(id));
+      CHECK(!table.remove(id));
+      CHECK(table.size() == 0);
+      CHECK(!table.call(ctrl_s, no_scopes));
+      CHECK(calls == 0);
+   }
+
+   // Inactive scopes (negative rank) are skipped. The highest rank wins,
+   // and among equal ranks, the most recently added.
+   void test_scopes()
+   {
+      accelerator_table table;
+      element outer, inner, other;
+      std::string log;
+
+      table.add(ctrl_s, [&]{ log += "g"; return true; });
+      table.add(ctrl_s, [&]{ log += "o"; return true; }, &outer);
+      table.add(ctrl_s, [&]{ log += "i"; return true; }, &inner);
+      table.add(ctrl_s, [&]{ log += "x"; return true; }, &other);
+
+      // inner is focused within outer, other is inactive
+      auto focused = [&](element const* e)
+      {
+         return (e == &inner)? 2 : (e == &outer)? 1 : -1;
+      };
+      CHECK(table.call(ctrl_s, focused));
+
+      // Only outer is active
+      auto outer_only = [&](element const* e) { return (e == &outer)? 1 : -1; };
+      CHECK(table.call(ctrl_s, outer_only));
+
+      // No scope is active: the global accelerator
+      auto none = [](element const*) { return -1; };
+      CHECK(table.call(ctrl_s, none));
+
+      // Equal ranks: the most recently added
+      CHECK(table.call(ctrl_s, no_scopes));
+
+      CHECK(log == "iogx");
+   }
+
+   // An action that no longer applies is removed, and the next candidate
+   // is tried
+   void test_stale()
+   {
+      accelerator_table table;
+      element scope;
+      std::string log;
+
+      table.add(ctrl_s, [&]{ log += "a"; return true; });
+      table.add(ctrl_s, [&]{ log += "b"; return false; }, &scope);
+      auto rank = [&](element const* e) { return (e == &scope)? 1 : -1; };
+
+      CHECK(table.call(ctrl_s, rank));
+      CHECK(log == "ba");
+      CHECK(table.size() == 1);
+
+      CHECK(table.call(ctrl_s, rank));
+      CHECK(log == "baa");
+
+      // Nothing applies
+      accelerator_table stale;
+      stale.add(ctrl_s, [&]{ log += "c"; return false; });
+      CHECK(!stale.call(ctrl_s, no_scopes));
+      CHECK(stale.size() == 0);
+      CHECK(log == "baac");
+   }
+
+   // Actions may add and remove accelerators, including themselves
+   void test_reentry()
+   {
+      accelerator_table table;
+      accelerator_table::accelerator_id self = 0;
+      int calls = 0;
+
+      self = table.add(ctrl_s,
+         [&]
+         {
+            ++calls;
+            table.remove(self);
+            for (int i = 0; i != 100; ++i)
+               table.add(ctrl_s, [&]{ calls += 1000; return true; });
+            return true;
+         }
+      );
+
+      CHECK(table.call(ctrl_s, no_scopes));
+      CHECK(calls == 1);
+      CHECK(table.size() == 100);
+      CHECK(table.call(ctrl_s, no_scopes));
+      CHECK(calls == 1001);
+   }
+}
+
+int main()
+{
+   test_lookup();
+   test_remove();
+   test_scopes();
+   test_stale();
+   test_reentry();
+
+   return test::report();
+}
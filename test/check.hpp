@@ -0,0 +1,37 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(ELEMENTS_TEST_CHECK_OCTOBER_16_2019)
+#define ELEMENTS_TEST_CHECK_OCTOBER_16_2019
+
+#include <cstdio>
+
+////////////////////////////////////////////////////////////////////////////////
+// A minimal test harness. CHECK reports the failed expressions and keeps
+// going. Tests return report() from main: non-zero if anything failed.
+////////////////////////////////////////////////////////////////////////////////
+namespace cycfi { namespace elements { namespace test
+{
+   inline int failures = 0;
+
+   inline bool check(bool cond, char const* expr, char const* file, int line)
+   {
+      if (!cond && failures++ < 50)
+         std::fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expr);
+      return cond;
+   }
+
+   inline int report()
+   {
+      if (failures)
+         std::fprintf(stderr, "%d check(s) failed\n", failures);
+      return failures != 0;
+   }
+}}}
+
+#define CHECK(cond) \
+   ::cycfi::elements::test::check(bool(cond), #cond, __FILE__, __LINE__)
+
+#endif
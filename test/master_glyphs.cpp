@@ -0,0 +1,231 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/glyphs.hpp>
+#include <elements/support/canvas.hpp>
+#include <elements/support/theme.hpp>
+#include "check.hpp"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace cycfi::elements;
+
+////////////////////////////////////////////////////////////////////////////////
+// The edits recorded with master_glyphs::edit are merged into one range and
+// applied by the next call to text. After any sequence of edits, the glyphs
+// must be the same as those of the text shaped from scratch.
+////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+   char const* face() { return get_theme().text_box_font; }
+   float const size = 14;
+
+   struct position
+   {
+      std::size_t    offset;
+      float          left;
+      float          right;
+
+      bool operator==(position const& rhs) const
+      {
+         return offset == rhs.offset && left == rhs.left && right == rhs.right;
+      }
+   };
+
+   std::vector<position> positions(master_glyphs& g, std::string const& text)
+   {
+      std::vector<position> r;
+      g.for_each(
+         [&](char const* utf8, float left, float right)
+         {
+            r.push_back({ std::size_t(utf8 - text.data()), left, right });
+            return true;
+         }
+      );
+      return r;
+   }
+
+   // Compare g, after its edits were applied, with the text shaped from
+   // scratch, on a single line and broken into lines of the given width.
+   bool same_as_shaped(master_glyphs& g, std::string const& text, float width)
+   {
+      master_glyphs expected(text.data(), text.data() + text.size(), face(), size);
+      bool same = CHECK(g.width() == expected.width());
+      same &= CHECK(positions(g, text) == positions(expected, text));
+
+      g.break_lines(width);
+      expected.break_lines(width);
+      auto const& a = g.lines();
+      auto const& b = expected.lines();
+      if (!CHECK(a.size() == b.size()))
+         return false;
+
+      for (std::size_t i = 0; i != a.size(); ++i)
+      {
+         same &= CHECK(a[i].begin() == b[i].begin() && a[i].end() == b[i].end());
+         same &= CHECK(a[i].width() == b[i].width() && a[i].y() == b[i].y());
+         for (auto p = a[i].begin(); p <= a[i].end(); ++p)
+         {
+            auto pa = a[i].position(p);
+            auto pb = b[i].position(p);
+            same &= CHECK(pa.str == pb.str && pa.left == pb.left && pa.right == pb.right);
+         }
+         for (float x = 0; x < a[i].width() + 10; x += 1.5f)
+            same &= CHECK(a[i].hit(x) == b[i].hit(x));
+      }
+      return same;
+   }
+
+   // Keeps a text and its glyphs in step
+   struct edited_text
+   {
+      edited_text(std::string text_)
+       : text(std::move(text_))
+       , glyphs(text.data(), text.data() + text.size(), face(), size)
+      {}
+
+      void replace(std::size_t pos, std::size_t n, std::string const& s)
+      {
+         text.replace(pos, n, s);
+         glyphs.edit(pos, n, s.size());
+      }
+
+      // Applies the edits. The text is copied, so that the glyphs do not
+      // rely on where it was.
+      void apply()
+      {
+         CHECK(glyphs.edited());
+         text = std::string(text);
+         glyphs.text(text.data(), text.data() + text.size());
+         CHECK(!glyphs.edited());
+      }
+
+      std::string    text;
+      master_glyphs  glyphs;
+   };
+
+   std::string const paragraphs =
+      "The quick brown fox\n"
+      "jumps over\n"
+      "\n"
+      "the lazy dog.\n"
+      "Pack my box with five dozen liquor jugs."
+      ;
+
+   void test_merges()
+   {
+      // One edit in the middle of a paragraph
+      {
+         edited_text t{ paragraphs };
+         t.replace(4, 5, "slow");
+         t.apply();
+         CHECK(same_as_shaped(t.glyphs, t.text, 80));
+      }
+
+      // Edits in the first and last paragraphs, merged into one range
+      // spanning the paragraphs in between
+      {
+         edited_text t{ paragraphs };
+         t.replace(0, 3, "A");
+         t.replace(t.text.size() - 6, 5, "mugs");
+         t.apply();
+         CHECK(same_as_shaped(t.glyphs, t.text, 80));
+      }
+
+      // An edit before an earlier edit, shifting it
+      {
+         edited_text t{ paragraphs };
+         t.replace(30, 4, "under");
+         t.replace(2, 0, "!!!!!!");
+         t.apply();
+         CHECK(same_as_shaped(t.glyphs, t.text, 100));
+      }
+
+      // Overlapping edits, the second one removing part of the first
+      {
+         edited_text t{ paragraphs };
+         t.replace(10, 0, "very very ");
+         t.replace(5, 12, "");
+         t.replace(8, 1, "XYZ");
+         t.apply();
+         CHECK(same_as_shaped(t.glyphs, t.text, 60));
+      }
+
+      // Edits that join and split paragraphs
+      {
+         edited_text t{ paragraphs };
+         t.replace(19, 1, " ");           // join the first two
+         t.replace(25, 0, "\n\n");        // split the result
+         t.replace(0, 0, "\n");           // a new empty first paragraph
+         t.apply();
+         CHECK(same_as_shaped(t.glyphs, t.text, 70));
+      }
+
+      // Remove everything, then type again
+      {
+         edited_text t{ paragraphs };
+         t.replace(0, t.text.size(), "");
+         t.apply();
+         CHECK(same_as_shaped(t.glyphs, t.text, 50));
+         t.replace(0, 0, "a\nb");
+         t.apply();
+         CHECK(same_as_shaped(t.glyphs, t.text, 50));
+      }
+
+      // Edits that do not add up to the new text: the whole text is shaped
+      {
+         edited_text t{ paragraphs };
+         t.replace(3, 2, "xx");
+         t.text += " and more\nand more";
+         t.apply();
+         CHECK(same_as_shaped(t.glyphs, t.text, 80));
+      }
+   }
+
+   // Random batches of edits, with lines broken between them
+   void test_random()
+   {
+      std::mt19937 rnd(11);
+      auto random_text = [&](std::size_t n)
+      {
+         static char const chars[] = "abc de fgh\n\nWi";
+         std::string s;
+         for (std::size_t i = 0; i != n; ++i)
+            s += chars[rnd() % (sizeof(chars) - 1)];
+         return s;
+      };
+
+      edited_text t{ random_text(200) };
+      float width = 60;
+      for (int i = 0; i != 2000; ++i)
+      {
+         for (int n = 1 + rnd() % 4; n != 0; --n)
+         {
+            auto pos = rnd() % (t.text.size() + 1);
+            auto len = std::min<std::size_t>(rnd() % 8, t.text.size() - pos);
+            t.replace(pos, len, random_text(rnd() % 6));
+         }
+         if (t.text.size() > 600)
+            t.replace(0, 300, "");
+         t.apply();
+
+         if (rnd() % 10 == 0)
+            width = float(20 + rnd() % 200);
+         if (!same_as_shaped(t.glyphs, t.text, width))
+            break;
+      }
+   }
+}
+
+int main()
+{
+   canvas::load_fonts(fs::current_path() / "resources");
+
+   test_merges();
+   test_random();
+
+   return test::report();
+}
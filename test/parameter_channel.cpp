@@ -0,0 +1,135 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/parameter_channel.hpp>
+#include <elements/element/element.hpp>
+#include <elements/view.hpp>
+#include "check.hpp"
+#include <array>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace cycfi::elements;
+
+namespace
+{
+   using value_list = std::vector<std::pair<element*, double>>;
+
+   value_list drain(parameter_channel& ch, bool* active = nullptr)
+   {
+      value_list r;
+      bool a = ch.drain([&](element& e, double val) { r.emplace_back(&e, val); });
+      if (active)
+         *active = a;
+      return r;
+   }
+
+   // The latest value per element, in the order the elements first changed
+   void test_coalesce(base_view& v)
+   {
+      std::array<element, 3> e;
+      parameter_channel ch(v, 8);
+
+      CHECK(ch.push(e[0], 1));
+      CHECK(ch.push(e[1], 2));
+      CHECK(ch.push(e[0], 3));
+      CHECK(ch.push(e[2], 4));
+      CHECK(ch.push(e[1], 5));
+
+      bool active = false;
+      auto r = drain(ch, &active);
+      CHECK(active);
+      CHECK((r == value_list{ { &e[0], 3 }, { &e[1], 5 }, { &e[2], 4 } }));
+
+      // A value pushed after a drain is delivered by the next one
+      CHECK(ch.push(e[2], 6));
+      r = drain(ch, &active);
+      CHECK(active);
+      CHECK((r == value_list{ { &e[2], 6 } }));
+
+      // Nothing changed: the channel goes idle
+      r = drain(ch, &active);
+      CHECK(r.empty());
+      CHECK(!active);
+   }
+
+   // Values for more than capacity elements are dropped
+   void test_capacity(base_view& v)
+   {
+      std::array<element, 3> e;
+      parameter_channel ch(v, 2);
+
+      CHECK(ch.push(e[0], 1));
+      CHECK(ch.push(e[1], 2));
+      CHECK(!ch.push(e[2], 3));
+      CHECK(ch.push(e[0], 4));
+
+      auto r = drain(ch);
+      CHECK((r == value_list{ { &e[0], 4 }, { &e[1], 2 } }));
+
+      // The slots stay with their elements
+      CHECK(!ch.push(e[2], 5));
+      CHECK(ch.push(e[1], 6));
+      r = drain(ch);
+      CHECK((r == value_list{ { &e[1], 6 } }));
+   }
+
+   // A producer thread pushes increasing values while we drain. Each
+   // element must see its values in order, and the last value pushed.
+   void test_concurrent(base_view& v)
+   {
+      constexpr int num_elements = 16;
+      constexpr int num_values = 200000;
+
+      std::array<element, num_elements> e;
+      parameter_channel ch(v, num_elements);
+
+      std::thread producer(
+         [&]
+         {
+            for (int n = 1; n <= num_values; ++n)
+               ch.push(e[n % num_elements], n);
+         }
+      );
+
+      std::array<double, num_elements> last{};
+      bool ordered = true;
+      auto f = [&](element& el, double val)
+      {
+         auto i = &el - e.data();
+         if (val < last[i])
+            ordered = false;
+         last[i] = val;
+      };
+
+      while (producer.joinable())
+      {
+         ch.drain(f);
+         bool done = true;
+         for (int i = 0; i != num_elements; ++i)
+         {
+            if (last[i] != num_values - ((num_values - i) % num_elements))
+               done = false;
+         }
+         if (done)
+            producer.join();
+      }
+
+      CHECK(ordered);
+      CHECK(drain(ch).empty());
+   }
+}
+
+int main()
+{
+   view view_(extent{ 100, 100 });
+
+   test_coalesce(view_);
+   test_capacity(view_);
+   test_concurrent(view_);
+
+   return test::report();
+}
@@ -0,0 +1,243 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements.hpp>
+#include "check.hpp"
+#include <random>
+#include <string>
+
+using namespace cycfi::elements;
+
+////////////////////////////////////////////////////////////////////////////////
+// The undo journal of basic_text_box: the replacements of an edit (and of a
+// typing run) are merged into one undo step that restores the text and the
+// selection.
+////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+   constexpr extent  view_size = { 400, 300 };
+   constexpr rect    view_bounds = { 0, 0, view_size.x, view_size.y };
+
+   std::string const original =
+      "The quick brown fox\n"
+      "jumps over the lazy dog.\n"
+      ;
+
+   // Exposes the journaled edits
+   class journaled_box : public basic_text_box
+   {
+   public:
+
+      using basic_text_box::basic_text_box;
+      using basic_text_box::begin_edit;
+      using basic_text_box::end_edit;
+      using basic_text_box::replace;
+   };
+
+   struct fixture
+   {
+      fixture()
+       : box(share(journaled_box(original)))
+       , surface(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, view_size.x, view_size.y))
+       , cr(cairo_create(surface))
+      {
+         view_.content({ share(align_left_top(hsize(view_size.x, hold(box)))) });
+         draw();
+      }
+
+      ~fixture()
+      {
+         cairo_destroy(cr);
+         cairo_surface_destroy(surface);
+      }
+
+      void draw()
+      {
+         view_.poll();
+         view_.draw(cr, view_bounds);
+      }
+
+      void click(point pos)
+      {
+         view_.click({ true, 1, mouse_button::left, 0, pos });
+         view_.click({ false, 1, mouse_button::left, 0, pos });
+         draw();
+      }
+
+      void type(std::string const& s)
+      {
+         for (auto c : s)
+         {
+            view_.text({ uint32_t(c), 0 });
+            draw();
+         }
+      }
+
+      void key(key_code k, int modifiers = 0)
+      {
+         view_.key({ k, key_action::press, modifiers });
+         draw();
+      }
+
+      // Undo as the user does: the text box ends its typing run first
+      void undo_key()
+      {
+         key(key_code::z, mod_control | mod_action);
+      }
+
+      int undo_steps()
+      {
+         int n = 0;
+         while (view_.undo())
+            ++n;
+         return n;
+      }
+
+      view                             view_{ view_size };
+      std::shared_ptr<journaled_box>   box;
+      cairo_surface_t*                 surface;
+      cairo_t*                         cr;
+   };
+
+   // Typing is one undo step while the caret stays at the end of the
+   // text typed so far
+   void test_typing()
+   {
+      fixture f;
+      f.click({ 30, 8 });
+      int caret = f.box->select_start();
+      CHECK(caret > 0);
+
+      f.type("abc");
+      std::string typed{ f.box->text() };
+      CHECK(typed == std::string{ original }.insert(caret, "abc"));
+
+      f.undo_key();
+      CHECK(f.box->text() == original);
+      CHECK(f.box->select_start() == caret && f.box->select_end() == caret);
+      CHECK(!f.view_.has_undo());
+
+      CHECK(f.view_.redo());
+      CHECK(f.box->text() == typed);
+      CHECK(f.box->select_start() == caret + 3);
+
+      // Moving the caret starts a new step
+      f.key(key_code::left);
+      f.type("x");
+      f.type("y");
+      CHECK(f.box->text() == std::string{ typed }.insert(caret + 2, "xy"));
+      f.undo_key();
+      CHECK(f.box->text() == typed);
+      f.undo_key();
+      CHECK(f.box->text() == original);
+      CHECK(!f.view_.has_undo());
+   }
+
+   // The replacements between begin_edit and end_edit are one step, however
+   // they overlap
+   void test_merge()
+   {
+      fixture f;
+      auto& box = *f.box;
+      auto edit = [&](auto&& replacements)
+      {
+         box.begin_edit(f.view_);
+         replacements();
+         box.end_edit(f.view_);
+      };
+
+      // Inside the text inserted so far, before and after it, and across it
+      edit(
+         [&]
+         {
+            box.replace(4, 5, "slow");          // The slow brown fox
+            box.replace(5, 1, "n");             // The snow brown fox
+            box.replace(0, 3, "A");             // A snow brown fox
+            box.replace(13, 3, "cat");          // A snow brown cat
+            box.replace(6, 7, "");              // A snowcat
+         }
+      );
+      std::string const merged = "A snowcat\njumps over the lazy dog.\n";
+      CHECK(box.text() == merged);
+
+      // Two separate edits
+      edit([&]{ box.replace(0, 1, "One"); });
+      edit([&]{ box.replace(box.text().size(), 0, "end"); });
+
+      CHECK(f.view_.undo());
+      CHECK(f.view_.undo());
+      CHECK(box.text() == merged);
+      CHECK(f.view_.undo());
+      CHECK(box.text() == original);
+      CHECK(!f.view_.undo());
+
+      CHECK(f.view_.redo());
+      CHECK(box.text() == merged);
+
+      // Random replacements, undone and redone in one step. Edits that
+      // change nothing leave no undo step.
+      std::mt19937 rnd(5);
+      for (int i = 0; i != 500; ++i)
+      {
+         auto before = std::string{ box.text() };
+         edit(
+            [&]
+            {
+               for (int n = 1 + rnd() % 6; n != 0; --n)
+               {
+                  auto size = int(box.text().size());
+                  int pos = rnd() % (size + 1);
+                  int len = std::min<int>(rnd() % 6, size - pos);
+                  box.replace(pos, len, std::string(rnd() % 4, char('a' + rnd() % 26)));
+               }
+            }
+         );
+         auto after = std::string{ box.text() };
+         if (after == before)
+            continue;                           // no undo step
+
+         CHECK(f.view_.undo());
+         CHECK(box.text() == before);
+         CHECK(f.view_.redo());
+         CHECK(box.text() == after);
+      }
+   }
+
+   // The oldest steps are dropped beyond the budget. The latest step is
+   // always kept.
+   void test_budget()
+   {
+      fixture f;
+      auto& box = *f.box;
+      std::string const big(1000, 'x');
+
+      // Room for three of these edits, with their bookkeeping
+      f.view_.undo_budget(3600);
+      for (int i = 0; i != 10; ++i)
+      {
+         box.begin_edit(f.view_);
+         box.replace(0, 0, big);
+         box.end_edit(f.view_);
+      }
+      CHECK(f.undo_steps() == 3);
+      CHECK(box.text().size() == original.size() + 7 * big.size());
+
+      f.view_.undo_budget(10);
+      box.begin_edit(f.view_);
+      box.replace(0, box.text().size(), "");
+      box.end_edit(f.view_);
+      CHECK(f.undo_steps() == 1);
+      CHECK(box.text().size() == original.size() + 7 * big.size());
+   }
+}
+
+int main()
+{
+   test_typing();
+   test_merge();
+   test_budget();
+
+   return test::report();
+}
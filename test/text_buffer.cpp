@@ -0,0 +1,130 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/text_buffer.hpp>
+#include "check.hpp"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace cycfi::elements;
+
+namespace
+{
+   // A buffer with only the required overrides, for the defaults of
+   // text_buffer (replace, substr)
+   class minimal_buffer : public text_buffer
+   {
+   public:
+
+      std::size_t          size() const override               { return _text.size(); }
+      char                 at(std::size_t pos) const override  { return _text[pos]; }
+      void                 assign(std::string_view text) override { _text = text; }
+      std::string const&   str() const override                { return _text; }
+
+      void insert(std::size_t pos, std::string_view text) override
+      {
+         _text.insert(pos, text.data(), text.size());
+      }
+
+      void erase(std::size_t pos, std::size_t n) override
+      {
+         _text.erase(pos, n);
+      }
+
+   private:
+
+      std::string          _text;
+   };
+
+   // Random edits, checked against a std::string
+   void test_edits(text_buffer& buf)
+   {
+      std::mt19937 rnd(3);
+      std::string expected = "Hello, world";
+      buf.assign(expected);
+
+      for (int i = 0; i != 10000; ++i)
+      {
+         auto pos = rnd() % (expected.size() + 1);
+         auto n = std::min<std::size_t>(rnd() % 10, expected.size() - pos);
+         std::string text(rnd() % 10, char('a' + rnd() % 26));
+         switch (rnd() % 3)
+         {
+            case 0:
+               buf.insert(pos, text);
+               expected.insert(pos, text);
+               break;
+            case 1:
+               buf.erase(pos, n);
+               expected.erase(pos, n);
+               break;
+            case 2:
+               buf.replace(pos, n, text);
+               expected.replace(pos, n, text);
+               break;
+         }
+         if (expected.size() > 1000)
+         {
+            buf.erase(0, 500);
+            expected.erase(0, 500);
+         }
+
+         CHECK(buf.size() == expected.size());
+         CHECK(buf.empty() == expected.empty());
+         CHECK(buf.view() == expected);
+         CHECK(buf.substr(pos, n) == expected.substr(pos, n));
+         if (!expected.empty())
+            CHECK(buf.at(pos % expected.size()) == expected[pos % expected.size()]);
+      }
+
+      // The snapshot is null terminated
+      CHECK(buf.str().c_str()[buf.size()] == '\0');
+      buf.assign("");
+      CHECK(buf.empty());
+      CHECK(buf.str().empty());
+   }
+
+   // The UTF-8 cursors step over whole code points
+   void test_cursors(text_buffer& buf)
+   {
+      // 1, 2, 3 and 4 byte code points
+      buf.assign(u8"aé€\U0001F600b");
+      std::vector<std::size_t> starts = { 0, 1, 3, 6, 10, 11 };
+
+      for (std::size_t i = 0; i + 1 < starts.size(); ++i)
+      {
+         CHECK(buf.next_char(starts[i]) == starts[i + 1]);
+         CHECK(buf.prev_char(starts[i + 1]) == starts[i]);
+      }
+
+      // From within a code point
+      CHECK(buf.next_char(7) == 10);
+      CHECK(buf.prev_char(8) == 6);
+
+      // At and past the ends
+      CHECK(buf.next_char(11) == 11);
+      CHECK(buf.next_char(100) == 11);
+      CHECK(buf.prev_char(0) == 0);
+      CHECK(buf.prev_char(100) == 10);
+
+      buf.assign("");
+      CHECK(buf.next_char(0) == 0);
+      CHECK(buf.prev_char(0) == 0);
+   }
+}
+
+int main()
+{
+   string_buffer sbuf;
+   test_edits(sbuf);
+   test_cursors(sbuf);
+
+   minimal_buffer mbuf;
+   test_edits(mbuf);
+   test_cursors(mbuf);
+
+   return test::report();
+}
@@ -0,0 +1,180 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/timer_wheel.hpp>
+#include "check.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace cycfi::elements;
+using namespace std::chrono_literals;
+
+namespace
+{
+   using time_point = timer_wheel::time_point;
+   using duration = timer_wheel::duration;
+
+   void call(timer_wheel::function_list& expired)
+   {
+      for (auto& f : expired)
+         f();
+      expired.clear();
+   }
+
+   void test_basics()
+   {
+      auto t0 = time_point{} + 1h;
+      timer_wheel w{ t0 };
+      timer_wheel::function_list expired;
+      std::vector<int> fired;
+
+      CHECK(w.size() == 0);
+      CHECK(w.next_expiry() == time_point::max());
+
+      w.add(t0, 10ms, [&]{ fired.push_back(10); });
+      auto id = w.add(t0, 5ms, [&]{ fired.push_back(5); });
+      w.add(t0, 20ms, [&]{ fired.push_back(20); });
+      CHECK(w.size() == 3);
+      CHECK(w.next_expiry() == t0 + 5ms);
+
+      // Not yet due
+      w.advance(t0 + 4ms, expired);
+      CHECK(expired.empty());
+
+      w.advance(t0 + 5ms, expired);
+      call(expired);
+      CHECK((fired == std::vector<int>{ 5 }));
+      CHECK(w.size() == 2);
+      CHECK(w.next_expiry() == t0 + 10ms);
+
+      // An expired timer can no longer be cancelled
+      CHECK(!w.cancel(id));
+
+      w.advance(t0 + 1s, expired);
+      call(expired);
+      CHECK((fired == std::vector<int>{ 5, 10, 20 }));
+      CHECK(w.size() == 0);
+      CHECK(w.next_expiry() == time_point::max());
+   }
+
+   void test_cancel()
+   {
+      auto t0 = time_point{} + 1h;
+      timer_wheel w{ t0 };
+      timer_wheel::function_list expired;
+      int fired = 0;
+
+      auto a = w.add(t0, 10ms, [&]{ ++fired; });
+      auto b = w.add(t0, 10ms, [&]{ fired += 10; });
+      CHECK(w.cancel(a));
+      CHECK(!w.cancel(a));
+      CHECK(!w.cancel(timer_wheel::timer_id{}));
+      CHECK(w.size() == 1);
+
+      // The node of a is reused. Its stale id must not cancel the new timer.
+      auto c = w.add(t0, 10ms, [&]{ fired += 100; });
+      CHECK(c.index == a.index);
+      CHECK(!w.cancel(a));
+
+      w.advance(t0 + 10ms, expired);
+      call(expired);
+      CHECK(fired == 110);
+      CHECK(!w.cancel(b));
+      CHECK(!w.cancel(c));
+   }
+
+   // A timer never fires early, nor in the tick it was added
+   void test_rounding()
+   {
+      auto t0 = time_point{} + 1h;
+      timer_wheel w{ t0 };
+      timer_wheel::function_list expired;
+
+      auto now = t0 + 2500us;
+      w.advance(now, expired);
+      w.add(now, 0ms, []{});
+      w.advance(now, expired);
+      CHECK(expired.empty());
+      w.advance(t0 + 3ms, expired);
+      CHECK(expired.size() == 1);
+   }
+
+   // Random timers, up to a few hours away (across all levels and beyond
+   // the range of the wheel), some of them cancelled. Each must fire in the
+   // first advance at or after its due time.
+   void test_random()
+   {
+      std::mt19937 rnd(7);
+      auto t0 = time_point{} + 1h;
+      auto now = t0;
+      timer_wheel w{ t0 };
+      timer_wheel::function_list expired;
+
+      struct timer
+      {
+         time_point           due;
+         timer_wheel::timer_id id;
+         int                  fired = 0;
+         bool                 cancelled = false;
+      };
+
+      std::vector<timer> timers(5000);
+      for (std::size_t i = 0; i != timers.size(); ++i)
+      {
+         auto max_delay = std::vector<long>{ 50, 3000, 200000, 5 * 3600000 }[i % 4];
+         duration delay{ rnd() % max_delay };
+         auto& t = timers[i];
+         t.due = now + std::max(delay, duration{ 1 });   // not in this tick
+         t.id = w.add(now, delay, [&timers, i]{ ++timers[i].fired; });
+      }
+      for (std::size_t i = 0; i < timers.size(); i += 7)
+         timers[i].cancelled = w.cancel(timers[i].id);
+
+      auto pending = [&]
+      {
+         std::size_t n = 0;
+         auto next = time_point::max();
+         for (auto const& t : timers)
+         {
+            if (!t.fired && !t.cancelled)
+            {
+               ++n;
+               next = std::min(next, t.due);
+            }
+         }
+         CHECK(w.size() == n);
+         CHECK(w.next_expiry() <= next);
+         return n;
+      };
+
+      while (pending() && w.size())
+      {
+         now += duration{ 1 + rnd() % 100000 };
+         w.advance(now, expired);
+         call(expired);
+
+         for (auto const& t : timers)
+         {
+            if (t.cancelled)
+               CHECK(t.fired == 0);
+            else if (t.due <= now)
+               CHECK(t.fired == 1);
+            else
+               CHECK(t.fired == 0);
+         }
+      }
+   }
+}
+
+int main()
+{
+   test_basics();
+   test_cancel();
+   test_rounding();
+   test_random();
+
+   return test::report();
+}